@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#include "hal/ticker_api.h"
+#include "hal/us_ticker_api.h"
+#include "boot_timeline.h"
+
+#include "ns_trace.h"
+#define TRACE_GROUP "boot"
+
+static boot_timeline_t timeline;
+
+static const char *const stage_names[BOOT_STAGE_COUNT] = {
+    "main",
+    "mesh_system_init",
+    "backhaul driver init",
+    "backhaul bootstrap ready",
+    "mesh start",
+    "mesh bootstrap ready"
+};
+
+void boot_timeline_mark(boot_stage_e stage)
+{
+    uint64_t now = ticker_read_us(get_us_ticker_data());
+
+    if (stage >= BOOT_STAGE_COUNT || (timeline.reached & (1 << stage))) {
+        return;
+    }
+
+    if (stage == BOOT_STAGE_MAIN_ENTRY) {
+        timeline.start_us = now;
+    }
+    timeline.stage_us[stage] = (uint32_t)(now - timeline.start_us);
+    timeline.reached |= 1 << stage;
+}
+
+const boot_timeline_t *boot_timeline_get(void)
+{
+    return &timeline;
+}
+
+void boot_timeline_print(void)
+{
+    tr_info("Boot timeline:");
+    for (int i = 0; i < BOOT_STAGE_COUNT; i++) {
+        if (timeline.reached & (1 << i)) {
+            tr_info("   %-26s %lu ms", stage_names[i], (unsigned long)(timeline.stage_us[i] / 1000));
+        }
+    }
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef enum boot_stage {
+    BOOT_STAGE_MAIN_ENTRY,          /**< main() entered */
+    BOOT_STAGE_MESH_SYSTEM_INIT,    /**< mesh_system_init() returned */
+    BOOT_STAGE_BACKHAUL_DRIVER,     /**< backhaul_driver_init() returned */
+    BOOT_STAGE_BACKHAUL_READY,      /**< Backhaul ARM_NWK_BOOTSTRAP_READY */
+    BOOT_STAGE_MESH_START,          /**< start_6lowpan() or mesh_network_up() called */
+    BOOT_STAGE_MESH_READY,          /**< RF interface ARM_NWK_BOOTSTRAP_READY */
+    BOOT_STAGE_COUNT
+} boot_stage_e;
+
+typedef struct boot_timeline {
+    uint64_t start_us;                      /**< Monotonic time of main() entry */
+    uint32_t stage_us[BOOT_STAGE_COUNT];    /**< Microseconds since main() entry */
+    uint8_t reached;                        /**< Bit mask of reached stages */
+} boot_timeline_t;
+
+/**
+ * Records the time a boot stage was first reached. Later calls for the
+ * same stage are ignored, so link flaps do not overwrite boot values.
+ */
+void boot_timeline_mark(boot_stage_e stage);
+
+/**
+ * Returns the boot timeline recorded so far.
+ */
+const boot_timeline_t *boot_timeline_get(void);
+
+/**
+ * Traces the boot timeline, one line per reached stage.
+ */
+void boot_timeline_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BOOT_TIMELINE_H */
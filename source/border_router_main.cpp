@@ -25,7 +25,15 @@
 #define EMAC 3
 #define CELL 4
 
-#if MBED_CONF_APP_BACKHAUL_DRIVER == CELL
+#ifndef MBED_CONF_APP_BACKHAUL_FAILOVER
+#define MBED_CONF_APP_BACKHAUL_FAILOVER 0
+#endif
+
+#if MBED_CONF_APP_BACKHAUL_FAILOVER && MBED_CONF_APP_BACKHAUL_DRIVER != EMAC
+#error "Backhaul failover requires EMAC as the primary backhaul driver"
+#endif
+
+#if MBED_CONF_APP_BACKHAUL_DRIVER == CELL || MBED_CONF_APP_BACKHAUL_FAILOVER
 #include "NanostackPPPInterface.h"
 #include "PPPInterface.h"
 #include "PPP.h"
@@ -44,6 +52,9 @@
 #include "cmsis_os.h"
 #include "arm_hal_interrupt.h"
 #include "nanostack_heap_region.h"
+#include "buffer_pools.h"
+#include "boot_timeline.h"
+#include "trace_sink.h"
 
 #include "mbed_trace.h"
 #define TRACE_GROUP "app"
@@ -86,6 +97,44 @@ static void emac_link_cb(bool up)
 }
 #endif
 
+#if MBED_CONF_APP_BACKHAUL_DRIVER == CELL || MBED_CONF_APP_BACKHAUL_FAILOVER
+static void cell_driver_init(void (*backhaul_driver_status_cb)(uint8_t, int8_t))
+{
+    /* Creates PPP service and onboard network stack already here for cellular
+     * connection to be able to override the link state changed callback */
+    PPP *ppp = &PPP::get_default_instance();
+    if (!ppp) {
+        tr_error("PPP not found");
+        exit(1);
+    }
+    OnboardNetworkStack *stack = &OnboardNetworkStack::get_default_instance();
+    if (!stack) {
+        tr_error("Onboard network stack not found");
+        exit(1);
+    }
+    OnboardNetworkStack::Interface *interface;
+    if (stack->add_ppp_interface(*ppp, true, &interface) != NSAPI_ERROR_OK) {
+        tr_error("Cannot add PPP interface");
+        exit(1);
+    }
+    Nanostack::PPPInterface *ns_if = static_cast<Nanostack::PPPInterface *>(interface);
+    ns_if->set_link_state_changed_callback(backhaul_driver_status_cb);
+
+    // Cellular interface configures it to PPP service and onboard stack created above
+    CellularInterface *net = CellularInterface::get_default_instance();
+    if (!net) {
+        tr_error("Default cellular interface not found");
+        exit(1);
+    }
+    net->set_default_parameters(); // from cellular nsapi .json configuration
+    net->set_blocking(false);
+    if (net->connect() != NSAPI_ERROR_OK) {
+        tr_error("Connect failure");
+        exit(1);
+    }
+}
+#endif
+
 /**
  * \brief Initializes the MAC backhaul driver.
  * This function is called by the border router module.
@@ -156,38 +205,7 @@ void backhaul_driver_init(void (*backhaul_driver_status_cb)(uint8_t, int8_t))
     }
 #elif MBED_CONF_APP_BACKHAUL_DRIVER == CELL
     tr_info("Using CELLULAR backhaul driver...");
-    /* Creates PPP service and onboard network stack already here for cellular
-     * connection to be able to override the link state changed callback */
-    PPP *ppp = &PPP::get_default_instance();
-    if (!ppp) {
-        tr_error("PPP not found");
-        exit(1);
-    }
-    OnboardNetworkStack *stack = &OnboardNetworkStack::get_default_instance();
-    if (!stack) {
-        tr_error("Onboard network stack not found");
-        exit(1);
-    }
-    OnboardNetworkStack::Interface *interface;
-    if (stack->add_ppp_interface(*ppp, true, &interface) != NSAPI_ERROR_OK) {
-        tr_error("Cannot add PPP interface");
-        exit(1);
-    }
-    Nanostack::PPPInterface *ns_if = static_cast<Nanostack::PPPInterface *>(interface);
-    ns_if->set_link_state_changed_callback(backhaul_driver_status_cb);
-
-    // Cellular interface configures it to PPP service and onboard stack created above
-    CellularInterface *net = CellularInterface::get_default_instance();
-    if (!net) {
-        tr_error("Default cellular interface not found");
-        exit(1);
-    }
-    net->set_default_parameters(); // from cellular nsapi .json configuration
-    net->set_blocking(false);
-    if (net->connect() != NSAPI_ERROR_OK) {
-        tr_error("Connect failure");
-        exit(1);
-    }
+    cell_driver_init(backhaul_driver_status_cb);
 #elif MBED_CONF_APP_BACKHAUL_DRIVER == ETH
     tr_info("Using ETH backhaul driver...");
     arm_eth_phy_device_register(mac, backhaul_driver_status_cb);
@@ -201,6 +219,18 @@ void backhaul_driver_init(void (*backhaul_driver_status_cb)(uint8_t, int8_t))
 #undef CELL
 }
 
+#if MBED_CONF_APP_BACKHAUL_FAILOVER
+/**
+ * \brief Initializes the cellular backhaul used for failover.
+ * This function is called by the border router module.
+ */
+void backhaul_secondary_driver_init(void (*backhaul_driver_status_cb)(uint8_t, int8_t))
+{
+    tr_info("Using CELLULAR secondary backhaul driver...");
+    cell_driver_init(backhaul_driver_status_cb);
+}
+#endif
+
 
 void appl_info_trace(void)
 {
@@ -231,15 +261,24 @@ void appl_info_trace(void)
  */
 int main()
 {
+    boot_timeline_mark(BOOT_STAGE_MAIN_ENTRY);
+
     mbed_trace_init(); // set up the tracing library
-    mbed_trace_print_function_set(trace_printer);
+    if (trace_sink_start()) {
+        mbed_trace_print_function_set(trace_sink_print);
+    } else {
+        mbed_trace_print_function_set(trace_printer);
+    }
     mbed_trace_config_set(TRACE_MODE_COLOR | APP_TRACE_LEVEL | TRACE_CARRIAGE_RETURN);
 
     // Have to let mesh_system do net_init_core in case we use
     // Nanostack::add_ethernet_interface()
     mesh_system_init();
+    boot_timeline_mark(BOOT_STAGE_MESH_SYSTEM_INIT);
 
     nanostack_heap_region_add();
+    buffer_pools_init();
+    nanostack_heap_region_report();
 
 #if MBED_CONF_APP_BACKHAUL_MAC_SRC == BOARD
     mbed_mac_address((char *)mac);
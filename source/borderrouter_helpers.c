@@ -11,37 +11,19 @@
 #include "common_functions.h"
 #include "ns_trace.h"
 #include "nsdynmemLIB.h"
+#include "eventOS_event.h"
+#include "eventOS_event_timer.h"
+#include "borderrouter_helpers.h"
+#include "dispatch_stats.h"
 #define TRACE_GROUP "app"
 
-static char tmp_print_buffer[128] = {0};
+#ifndef MBED_CONF_APP_BACKHAUL_LINK_HOLD_MS
+#define MBED_CONF_APP_BACKHAUL_LINK_HOLD_MS 3000
+#endif
 
-char *print_ipv6(const void *addr_ptr)
-{
-    ip6tos(addr_ptr, tmp_print_buffer);
-    return tmp_print_buffer;
-}
-
-char *print_ipv6_prefix(const uint8_t *prefix, uint8_t prefix_len)
-{
-    char *str = tmp_print_buffer;
-    int retval;
-    char tmp[40];
-    uint8_t addr[16] = {0};
-
-    if (prefix_len != 0) {
-        if (prefix == NULL || prefix_len > 128) {
-            return "<err>";
-        }
-        bitcopy(addr, prefix, prefix_len);
-    }
-
-    ip6tos(addr, tmp);
-    retval = snprintf(str, 128, "%s/%u", tmp, prefix_len);
-    if (retval <= 0) {
-        return "";
-    }
-    return str;
-}
+/* Backhaul interface is kept while the PHY link is down for less than the hold time */
+static bool backhaul_suspended = false;
+static uint32_t backhaul_suspend_ticks;
 
 void print_memory_stats(void)
 {
@@ -56,3 +38,45 @@ void print_memory_stats(void)
     }
 }
 
+
+bool backhaul_link_hold_suspend(int8_t tasklet_id, int8_t interface_id)
+{
+    if (MBED_CONF_APP_BACKHAUL_LINK_HOLD_MS == 0 || interface_id == -1) {
+        return false;
+    }
+    if (!backhaul_suspended) {
+        backhaul_suspended = true;
+        backhaul_suspend_ticks = eventOS_event_timer_ticks();
+        dispatch_stats_timer_request(BACKHAUL_LINK_HOLD_TIMER, ARM_LIB_SYSTEM_TIMER_EVENT,
+                                     tasklet_id, MBED_CONF_APP_BACKHAUL_LINK_HOLD_MS);
+        tr_info("Backhaul link down, interface suspended");
+    }
+    return true;
+}
+
+bool backhaul_link_hold_resume(int8_t tasklet_id)
+{
+    if (!backhaul_suspended) {
+        return false;
+    }
+    dispatch_stats_timer_cancel(BACKHAUL_LINK_HOLD_TIMER, tasklet_id);
+    backhaul_suspended = false;
+    tr_info("Backhaul link up, interface resumed after %lu ms",
+            (unsigned long)eventOS_event_timer_ticks_to_ms(eventOS_event_timer_ticks() - backhaul_suspend_ticks));
+    return true;
+}
+
+bool backhaul_link_hold_expired(uint8_t timer_id)
+{
+    if (timer_id != BACKHAUL_LINK_HOLD_TIMER || !backhaul_suspended) {
+        return false;
+    }
+    backhaul_suspended = false;
+    tr_info("Backhaul link down over %d ms", MBED_CONF_APP_BACKHAUL_LINK_HOLD_MS);
+    return true;
+}
+
+bool backhaul_link_hold_active(void)
+{
+    return backhaul_suspended;
+}
@@ -11,10 +11,50 @@ extern "C"
 {
 #endif
 
-char *print_ipv6(const void *addr_ptr);
-char *print_ipv6_prefix(const uint8_t *prefix, uint8_t prefix_len);
 void print_memory_stats(void);
 
+/* Tasklet timer of the backhaul link hold, not to be used for anything else */
+#define BACKHAUL_LINK_HOLD_TIMER 10
+
+/**
+ * Suspends the backhaul interface when its PHY link goes down, for
+ * "backhaul-link-hold-ms". Addresses and routes are kept meanwhile.
+ *
+ * \return true if the interface is held, false if it must go down now
+ */
+bool backhaul_link_hold_suspend(int8_t tasklet_id, int8_t interface_id);
+
+/**
+ * Resumes a suspended backhaul interface when its PHY link comes back.
+ *
+ * \return true if the interface was suspended
+ */
+bool backhaul_link_hold_resume(int8_t tasklet_id);
+
+/**
+ * Checks a tasklet timer event for the end of the link hold.
+ *
+ * \return true if the link stayed down for the hold time and the backhaul
+ *         interface must go down now
+ */
+bool backhaul_link_hold_expired(uint8_t timer_id);
+
+/**
+ * Returns true while the backhaul interface is suspended.
+ */
+bool backhaul_link_hold_active(void);
+
+/* True if traces of the level, for example TRACE_LEVEL_DEBUG, are printed */
+#define trace_level_active(level) ((mbed_trace_config_get() & (level)) != 0)
+
+/*
+ * As tr_debug() and tr_info(), but the arguments are evaluated only when
+ * the level is active. Use these when the arguments format addresses with
+ * tr_ipv6() or tr_ipv6_prefix().
+ */
+#define tr_debug_lazy(...) do { if (trace_level_active(TRACE_LEVEL_DEBUG)) { tr_debug(__VA_ARGS__); } } while (0)
+#define tr_info_lazy(...) do { if (trace_level_active(TRACE_LEVEL_INFO)) { tr_info(__VA_ARGS__); } } while (0)
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,7 +8,7 @@
 #if MBED_CONF_APP_MESH_MODE == LOWPAN_ND
 
 #include <string.h>
-#include <stdlib.h>
+#include <stdio.h>
 #include "ns_types.h"
 #include "eventOS_event.h"
 #include "eventOS_event_timer.h"
@@ -16,10 +16,25 @@
 #include "multicast_api.h"
 #include "whiteboard_api.h"
 #include "platform/arm_hal_timer.h"
+#include "platform/arm_hal_phy.h"
 #include "borderrouter_tasklet.h"
 #include "borderrouter_helpers.h"
 #include "net_interface.h"
-#include "cfg_parser.h"
+#include "br_config.h"
+#include "br_config_store.h"
+#include "mesh_scale_report.h"
+#include "boot_timeline.h"
+#include "mld_proxy.h"
+#include "metrics_exporter.h"
+#include "table_diff.h"
+#include "dispatch_stats.h"
+#include "packet_capture.h"
+#include "buffer_pools.h"
+#include "memory_pressure.h"
+#include "mac_storage.h"
+#include "multicast_groups.h"
+#include "iphc_contexts.h"
+#include "trickle_controller.h"
 #include "rf_wrapper.h"
 #include "nwk_stats_api.h"
 #include "net_interface.h"
@@ -29,14 +44,53 @@
 #include "ethernet_mac_api.h"
 #include "sw_mac.h"
 
-#include "static_6lowpan_config.h"
-
 #include "ns_trace.h"
 #define TRACE_GROUP "brro"
 
 #define NR_BACKHAUL_INTERFACE_PHY_DRIVER_READY 2
 #define NR_BACKHAUL_INTERFACE_PHY_DOWN  3
 
+#define NR_BACKHAUL_SECONDARY_PHY_DRIVER_READY 4
+#define NR_BACKHAUL_SECONDARY_PHY_DOWN 5
+#define BACKHAUL_HEALTH_TIMER 11
+
+#ifndef MBED_CONF_APP_BACKHAUL_FAILOVER
+#define MBED_CONF_APP_BACKHAUL_FAILOVER 0
+#endif
+
+#ifndef MBED_CONF_APP_BACKHAUL_HEALTH_INTERVAL_MS
+#define MBED_CONF_APP_BACKHAUL_HEALTH_INTERVAL_MS 5000
+#endif
+
+#ifndef MBED_CONF_APP_BACKHAUL_FAILBACK_PROBES
+#define MBED_CONF_APP_BACKHAUL_FAILBACK_PROBES 3
+#endif
+
+/* Interface metrics: the backhaul with the lowest metric carries the default route */
+#define BACKHAUL_METRIC_ACTIVE 0
+#define BACKHAUL_METRIC_STANDBY 1000
+#define BACKHAUL_METRIC_FAILED 2000
+
+#define RPL_AIRTIME_TIMER 12
+
+/* RFC 6550 lollipop counter window, and how far a new root version may be stepped */
+#define RPL_SEQUENCE_WINDOW 16
+#define RPL_VERSION_STEPS_MAX 32
+
+#ifndef MBED_CONF_APP_RPL_AIRTIME_WINDOW_MS
+#define MBED_CONF_APP_RPL_AIRTIME_WINDOW_MS 60000
+#endif
+
+#define RPL_TRICKLE_TIMER 13
+
+#ifndef MBED_CONF_APP_RPL_ADAPTIVE_TRICKLE
+#define MBED_CONF_APP_RPL_ADAPTIVE_TRICKLE 0
+#endif
+
+#ifndef MBED_CONF_APP_RPL_TRICKLE_INTERVAL_MS
+#define MBED_CONF_APP_RPL_TRICKLE_INTERVAL_MS 60000
+#endif
+
 const uint8_t addr_unspecified[16] = {0};
 static mac_api_t *api;
 static eth_mac_api_t *eth_mac_api;
@@ -63,18 +117,36 @@ typedef struct {
     uint8_t next_hop[16];
 } route_info_t;
 
+/* MAC transmit counters of the mesh over one airtime measurement window */
+typedef struct {
+    uint32_t bc_tx_count;
+    uint32_t tx_bytes;
+} airtime_sample_t;
+
 /* Border router channel list */
 static channel_list_s channel_list;
 
-/* Channel masks for different RF types */
-static const uint32_t channel_mask_0_2_4ghz = 0x07fff800;
-
 /* Border router settings */
 static border_router_setup_s br;
 
 /* RPL routing settings */
 static rpl_setup_info_t rpl_setup_info;
 
+/* MAC statistics of the RF interface */
+static mac_statistics_t mac_stats;
+
+/* Airtime windows: counters at the start of the current window, the last
+ * complete window and the last complete window before a DODAG update */
+static airtime_sample_t airtime_base;
+static airtime_sample_t airtime_last;
+static airtime_sample_t airtime_before;
+
+/* Report the window after a DODAG update */
+static bool airtime_pending;
+
+/* Compiled configuration with the stored overlay applied */
+static br_config_t runtime_config;
+
 /* DODAG configuration */
 static dodag_config_t dodag_config;
 
@@ -87,6 +159,9 @@ static route_info_t backhaul_route;
 /* Should prefix on the backhaul used for PAN as well? */
 static uint8_t rf_prefix_from_backhaul = 0;
 
+/* Should the PAN be started without waiting for the backhaul? */
+static uint8_t mesh_before_backhaul = 0;
+
 static net_6lowpan_mode_e operating_mode = NET_6LOWPAN_BORDER_ROUTER;
 static net_6lowpan_mode_extension_e operating_mode_extension = NET_6LOWPAN_ND_WITH_MLE;
 static interface_bootstrap_state_e net_6lowpan_state = INTERFACE_IDLE_PHY_NOT_READY;
@@ -97,6 +172,7 @@ static const uint8_t gp16_address_suffix[6] = {0x00, 0x00, 0x00, 0xff, 0xfe, 0x0
 
 static int8_t br_tasklet_id = -1;
 static int8_t net_6lowpan_id = -1;
+static int8_t rf_driver_id = -1;
 static int8_t backhaul_if_id = -1;
 
 /* Network statistics */
@@ -114,29 +190,53 @@ static void app_parse_network_event(arm_event_s *event);
 static void borderrouter_tasklet(arm_event_s *event);
 static void initialize_channel_list(uint32_t channel);
 static void start_6lowpan(const uint8_t *backhaul_address);
+static void rf_prefix_update(const uint8_t *backhaul_address);
 static int8_t rf_interface_init(void);
 static void load_config(void);
+static bool mesh_config_valid(const br_config_t *config);
+static bool config_apply(const br_config_t *config, uint8_t changed);
+static void airtime_window_start(void);
+static void airtime_window_close(void);
+static void rpl_trickle_adapt(void);
+static bool memory_pressure_apply(uint8_t action, bool active);
 
 void border_router_tasklet_start(void)
 {
+    /* Before the drivers are tapped */
+    packet_capture_start();
+
     /* initialize Radio module*/
     net_6lowpan_id = rf_interface_init();
 
+    br_config_store_load(&runtime_config);
     load_config();
+    if (!mesh_config_valid(&runtime_config)) {
+        tr_error("RF configuration not supported, mesh interface is not started");
+    }
+    br_config_store_start(config_apply);
 
     protocol_stats_start(&nwk_stats);
+    metrics_exporter_start(&nwk_stats);
+    mesh_scale_report_start();
+    dispatch_stats_start();
+    memory_pressure_start(memory_pressure_apply);
 
-    eventOS_event_handler_create(
+    dispatch_stats_handler_create(
         &borderrouter_tasklet,
         ARM_LIB_TASKLET_INIT_EVENT);
 }
 
+
 static void print_interface_addr(int id)
 {
     uint8_t address_buf[128];
     int address_count = 0;
     char buf[128];
 
+    if (!trace_level_active(TRACE_LEVEL_INFO)) {
+        return;
+    }
+
     if (arm_net_address_list_get(id, 128, address_buf, &address_count) == 0) {
         uint8_t *t_buf = address_buf;
         for (int i = 0; i < address_count; ++i) {
@@ -159,60 +259,75 @@ static void initialize_channel_list(uint32_t channel)
     }
 }
 
-static void load_config(void)
+/**
+  * \brief Returns the configured RF channel, 0 to scan all channels.
+  *
+  * Returns -1 if the radio does not have the channel on the configured
+  * channel page.
+  */
+static int32_t mesh_channel_get(const br_config_t *config)
 {
-    const char *prefix, *psk;
-    uint8_t nd_prefix[16];
+    const phy_device_driver_s *driver = arm_net_phy_driver_pointer(rf_driver_id);
+    const phy_device_channel_page_s *page;
+    uint32_t channel = config->rf_channel;
 
-    prefix = cfg_string(global_config, "PREFIX", NULL);
-
-    if (!prefix) {
-        tr_error("No RF prefix in configuration!");
-        return;
+    if (channel == 0) {
+        return 0;
     }
 
-    stoip6(prefix, strlen(prefix), nd_prefix);
-
-    prefix = cfg_string(global_config, "BACKHAUL_PREFIX", NULL);
-    if (!prefix) {
-        tr_error("No backhaul prefix in configuration!");
-        return;
+    if (!driver || !driver->phy_channel_pages) {
+        return -1;
     }
-
-    stoip6(prefix, strlen(prefix), backhaul_prefix);
-    memset(&backhaul_prefix[8], 0, 8);
-
-    prefix = cfg_string(global_config, "MULTICAST_ADDR", NULL);
-    if (!prefix) {
-        tr_error("No multicast address in configuration!");
-        return;
+    for (page = driver->phy_channel_pages; page->rf_channel_configuration; page++) {
+        const phy_rf_channel_configuration_s *rf_config = page->rf_channel_configuration;
+        /* Channels 11-26 of page 0 are the 2.4 GHz band */
+        uint32_t first = (page->channel_page == CHANNEL_PAGE_0 &&
+                          rf_config->channel_0_center_frequency >= 2400000000U) ? 11 : 0;
+
+        if (page->channel_page == config->rf_channel_page &&
+                channel >= first && channel < first + rf_config->number_of_channels) {
+            return channel;
+        }
     }
+    return -1;
+}
 
-    stoip6(prefix, strlen(prefix), multicast_addr);
+/**
+  * \brief Checks that the radio supports the configured channel.
+  */
+static bool mesh_config_valid(const br_config_t *config)
+{
+    if (net_6lowpan_id >= 0 && mesh_channel_get(config) < 0) {
+        tr_error("RF channel %lu not supported on channel page %u",
+                 (unsigned long)config->rf_channel, config->rf_channel_page);
+        return false;
+    }
+    return true;
+}
 
+static void mesh_interface_config(const uint8_t *nd_prefix)
+{
     /* Set up channel page and channgel mask */
     memset(&channel_list, 0, sizeof(channel_list));
-    channel_list.channel_page = (channel_page_e)cfg_int(global_config, "RF_CHANNEL_PAGE", CHANNEL_PAGE_0);
-    channel_list.channel_mask[0] = cfg_int(global_config, "RF_CHANNEL_MASK", channel_mask_0_2_4ghz);
+    channel_list.channel_page = (channel_page_e)runtime_config.rf_channel_page;
+    channel_list.channel_mask[0] = runtime_config.rf_channel_mask;
 
-    prefix = cfg_string(global_config, "NETWORK_ID", "NETWORK000000000");
-    memcpy(br.network_id, prefix, 16);
+    memcpy(br.network_id, runtime_config.network_id, 16);
 
-    br.mac_panid = cfg_int(global_config, "PAN_ID", 0x0691);
+    br.mac_panid = runtime_config.pan_id;
     tr_info("PANID: %x", br.mac_panid);
-    br.mac_short_adr = cfg_int(global_config, "SHORT_MAC_ADDRESS", 0xffff);
-    br.ra_life_time = cfg_int(global_config, "RA_ROUTER_LIFETIME", 1024);
-    br.beacon_protocol_id = cfg_int(global_config, "BEACON_PROTOCOL_ID", 4);
+    br.mac_short_adr = runtime_config.short_mac_address;
+    br.ra_life_time = runtime_config.ra_router_lifetime;
+    br.beacon_protocol_id = runtime_config.beacon_protocol_id;
 
     memcpy(br.lowpan_nd_prefix, nd_prefix, 8);
-    br.abro_version_num = 0;
 
     /* RPL routing setup */
-    rpl_setup_info.rpl_instance_id = cfg_int(global_config, "RPL_INSTANCE_ID", 1);
+    rpl_setup_info.rpl_instance_id = runtime_config.rpl_instance_id;
     rpl_setup_info.rpl_setups = RPL_FLAGS;
 
     /* generate DODAG ID */
-    memcpy(rpl_setup_info.DODAG_ID, nd_prefix, 8);
+    memcpy(rpl_setup_info.DODAG_ID, br.lowpan_nd_prefix, 8);
     if (br.mac_short_adr < 0xfffe) {
         memcpy(&rpl_setup_info.DODAG_ID[8], gp16_address_suffix, 6);
         rpl_setup_info.DODAG_ID[14] = (br.mac_short_adr >> 8);
@@ -221,21 +336,42 @@ static void load_config(void)
         rf_read_mac_address(&rpl_setup_info.DODAG_ID[8]);
         rpl_setup_info.DODAG_ID[8] ^= 2;
     }
+}
 
-    /* DODAG configuration */
-    dodag_config.DAG_DIO_INT_DOUB = cfg_int(global_config, "RPL_IDOUBLINGS", 12);
-    dodag_config.DAG_DIO_INT_MIN = cfg_int(global_config, "RPL_IMIN", 9);
-    dodag_config.DAG_DIO_REDU = cfg_int(global_config, "RPL_K", 10);
-    dodag_config.DAG_MAX_RANK_INC = cfg_int(global_config, "RPL_MAX_RANK_INC", 2048);
-    dodag_config.DAG_MIN_HOP_RANK_INC = cfg_int(global_config, "RPL_MIN_HOP_RANK_INC", 128);
-    dodag_config.LIFE_IN_SECONDS = cfg_int(global_config, "RPL_LIFETIME_UNIT", 64);
-    dodag_config.LIFETIME_UNIT = cfg_int(global_config, "RPL_DEFAULT_LIFETIME", 60);
-    dodag_config.DAG_SEC_PCS = cfg_int(global_config, "RPL_PCS", 1);
-    dodag_config.DAG_OCP = cfg_int(global_config, "RPL_OCP", 1);
+static void backhaul_route_load(void)
+{
+    memcpy(backhaul_route.next_hop, runtime_config.backhaul_next_hop, 16);
+    memcpy(backhaul_route.prefix, runtime_config.backhaul_default_route.prefix, 16);
+    backhaul_route.prefix_len = runtime_config.backhaul_default_route.prefix_len;
+}
 
-    bool dynamic_bootstrap = (net_ipv6_mode_e)cfg_int(global_config, "BACKHAUL_DYNAMIC_BOOTSTRAP", 0);
+static void dodag_config_load(void)
+{
+    dodag_config.DAG_DIO_INT_DOUB = runtime_config.rpl_idoublings;
+    dodag_config.DAG_DIO_INT_MIN = runtime_config.rpl_imin;
+    dodag_config.DAG_DIO_REDU = runtime_config.rpl_k;
+    dodag_config.DAG_MAX_RANK_INC = runtime_config.rpl_max_rank_inc;
+    dodag_config.DAG_MIN_HOP_RANK_INC = runtime_config.rpl_min_hop_rank_inc;
+    dodag_config.LIFE_IN_SECONDS = runtime_config.rpl_lifetime_unit;
+    dodag_config.LIFETIME_UNIT = runtime_config.rpl_default_lifetime;
+    if (memory_pressure_active(MEMORY_PRESSURE_LIFETIME)) {
+        /* DAO routes of departed nodes expire sooner */
+        dodag_config.LIFETIME_UNIT = MEMORY_PRESSURE_LIFETIME_SHORTENED(runtime_config.rpl_default_lifetime);
+    }
+    dodag_config.DAG_SEC_PCS = runtime_config.rpl_pcs;
+    dodag_config.DAG_OCP = runtime_config.rpl_ocp;
+}
 
-    if (dynamic_bootstrap == 1) {
+static void load_config(void)
+{
+    memcpy(backhaul_prefix, runtime_config.backhaul_prefix, 16);
+    memcpy(multicast_addr, runtime_config.multicast_addr, 16);
+
+    mesh_interface_config(runtime_config.prefix);
+
+    dodag_config_load();
+
+    if (runtime_config.backhaul_dynamic_bootstrap) {
         backhaul_bootstrap_mode = NET_IPV6_BOOTSTRAP_AUTONOMOUS;
         tr_info("NET_IPV6_BOOTSTRAP_AUTONOMOUS");
     } else {
@@ -244,60 +380,24 @@ static void load_config(void)
     }
 
     /* Bootstrap mode for the backhaul interface */
-    rf_prefix_from_backhaul = cfg_int(global_config, "PREFIX_FROM_BACKHAUL", 0);
-
-    /* Backhaul default route */
-    memset(&backhaul_route, 0, sizeof(backhaul_route));
-    psk = cfg_string(global_config, "BACKHAUL_NEXT_HOP", NULL);
-
-    if (psk) {
-        stoip6(psk, strlen(psk), backhaul_route.next_hop);
-    }
-
-    psk = cfg_string(global_config, "BACKHAUL_DEFAULT_ROUTE", NULL);
+    rf_prefix_from_backhaul = runtime_config.prefix_from_backhaul;
+    mesh_before_backhaul = runtime_config.mesh_before_backhaul;
 
-    if (psk) {
-        char *prefix, route_buf[255] = {0};
+    backhaul_route_load();
 
-        /* copy the config value to a non-const buffer */
-        strncpy(route_buf, psk, sizeof(route_buf) - 1);
-        prefix = strtok(route_buf, "/");
-        backhaul_route.prefix_len = atoi(strtok(NULL, "/"));
-
-        stoip6(prefix, strlen(prefix), backhaul_route.prefix);
-    }
-
-    prefix = cfg_string(global_config, "SECURITY_MODE", "NONE");
-
-    if (strcmp(prefix, "NONE") == 0) {
-        link_security_mode = NET_SEC_MODE_NO_LINK_SECURITY;
+    link_security_mode = runtime_config.security_mode;
+    if (link_security_mode == NET_SEC_MODE_NO_LINK_SECURITY) {
         tr_warn("Security NOT enabled");
         return;
     }
 
-    psk = cfg_string(global_config, "PSK_KEY", NULL);
+    link_layer_psk.key_id = runtime_config.psk_key_id;
+    memcpy(link_layer_psk.security_key, runtime_config.psk_key, 16);
 
-    if (!psk) {
-        tr_error("No PSK set in configuration!");
-        return;
-    }
-
-    link_layer_psk.key_id = cfg_int(global_config, "PSK_KEY_ID", 1);
-    memcpy(link_layer_psk.security_key, psk, 16);
-
-    if (strcmp(prefix, "PSK") == 0) {
+    if (link_security_mode == NET_SEC_MODE_PSK_LINK_SECURITY) {
         tr_debug("Using PSK security mode, key ID = %d", link_layer_psk.key_id);
-        link_security_mode = NET_SEC_MODE_PSK_LINK_SECURITY;
-    } else if (strcmp(prefix, "PANA") == 0) {
-        const char *mode = cfg_string(global_config, "PANA_MODE", "PSK");
-        link_security_mode = NET_SEC_MODE_PANA_LINK_SECURITY;
-        if (strcmp(mode, "ECC") == 0) {
-            pana_security_suite = NET_TLS_ECC_CIPHER;
-        } else if (strcmp(mode, "ECC+PSK") == 0) {
-            pana_security_suite = NET_TLS_PSK_AND_ECC_CIPHER;
-        } else {
-            pana_security_suite = NET_TLS_PSK_CIPHER;
-        }
+    } else {
+        pana_security_suite = runtime_config.pana_suite;
     }
 }
 
@@ -307,16 +407,19 @@ static int8_t rf_interface_init(void)
     int8_t rfid = -1;
     int8_t rf_phy_device_register_id = rf_device_register();
     tr_debug("RF device ID: %d", rf_phy_device_register_id);
+    rf_driver_id = rf_phy_device_register_id;
 
     if (rf_phy_device_register_id >= 0) {
         mac_description_storage_size_t storage_sizes;
-        storage_sizes.device_decription_table_size = 32;
-        storage_sizes.key_description_table_size = 3;
-        storage_sizes.key_lookup_size = 1;
-        storage_sizes.key_usage_size = 3;
+        mac_storage_sizes_get(&storage_sizes, 3, 1, 3);
         if (!api) {
+            uint32_t heap_before = mac_storage_heap_allocated();
             api = ns_sw_mac_create(rf_phy_device_register_id, &storage_sizes);
+            mac_storage_report(&storage_sizes, heap_before);
+            ns_sw_mac_statistics_start(api, &mac_stats);
         }
+        memory_pressure_join_gate(rf_phy_device_register_id);
+        packet_capture_tap(rf_phy_device_register_id, phy_name, CAPTURE_IF_MESH);
         rfid = arm_nwk_interface_lowpan_init(api, phy_name);
         tr_debug("RF interface ID: %d", rfid);
     }
@@ -339,9 +442,18 @@ static void borderrouter_backhaul_phy_status_cb(uint8_t link_up, int8_t driver_i
         event.event_id = NR_BACKHAUL_INTERFACE_PHY_DRIVER_READY;
     }
 
-    eventOS_event_send(&event);
+    dispatch_stats_event_send(&event);
 }
 
+#if MBED_CONF_APP_BACKHAUL_FAILOVER
+/* Secondary (cellular) backhaul */
+static int8_t backhaul_secondary_if_id = -1;
+static eth_mac_api_t *secondary_eth_mac_api;
+static bool backhaul_secondary_ready = false;
+static bool backhaul_failed_over = false;
+static uint8_t primary_healthy_probes;
+#endif
+
 static int backhaul_interface_up(int8_t driver_id)
 {
     int retval = -1;
@@ -350,6 +462,7 @@ static int backhaul_interface_up(int8_t driver_id)
     } else {
         if (!eth_mac_api) {
             eth_mac_api = ethernet_mac_create(driver_id);
+            packet_capture_tap(driver_id, "bh0", CAPTURE_IF_BACKHAUL);
         }
 
         backhaul_if_id = arm_nwk_interface_ethernet_init(eth_mac_api, "bh0");
@@ -361,6 +474,12 @@ static int backhaul_interface_up(int8_t driver_id)
             }
             arm_nwk_interface_configure_ipv6_bootstrap_set(
                 backhaul_if_id, backhaul_bootstrap_mode, backhaul_prefix);
+#if MBED_CONF_APP_BACKHAUL_FAILOVER
+            /* Stay behind the secondary until the health probe fails back */
+            if (backhaul_failed_over) {
+                arm_net_interface_set_metric(backhaul_if_id, BACKHAUL_METRIC_FAILED);
+            }
+#endif
             arm_nwk_interface_up(backhaul_if_id);
             retval = 0;
         }
@@ -379,6 +498,158 @@ static int backhaul_interface_down(void)
     return retval;
 }
 
+static void backhaul_link_lost(void)
+{
+    if (backhaul_interface_down() != 0) {
+        tr_error("Backhaul interface down failed");
+    } else {
+        tr_debug("Backhaul interface is down");
+        net_backhaul_state = INTERFACE_IDLE_STATE;
+    }
+}
+
+static void backhaul_route_add(void)
+{
+    uint8_t *next_hop_ptr;
+    int8_t retval;
+    if (memcmp(backhaul_route.next_hop, addr_unspecified, 16) == 0) {
+        tr_info("Next hop not defined");
+        next_hop_ptr = NULL;
+    } else {
+        next_hop_ptr = backhaul_route.next_hop;
+    }
+
+    tr_info("Backhaul default route:");
+    tr_info_lazy("   prefix:   %s", tr_ipv6_prefix(backhaul_route.prefix, backhaul_route.prefix_len));
+    tr_info_lazy("   next hop: %s", next_hop_ptr ? tr_ipv6(backhaul_route.next_hop) : "on-link");
+
+    retval = arm_net_route_add(backhaul_route.prefix, backhaul_route.prefix_len,
+                               next_hop_ptr, 0xffffffff, 128, backhaul_if_id);
+
+    if (retval < 0) {
+        tr_error("Failed to add backhaul default route, retval = %d", retval);
+    }
+}
+
+static void backhaul_route_delete(void)
+{
+    bool on_link = memcmp(backhaul_route.next_hop, addr_unspecified, 16) == 0;
+
+    if (arm_net_route_delete(backhaul_route.prefix, backhaul_route.prefix_len,
+                             on_link ? NULL : backhaul_route.next_hop, backhaul_if_id) < 0) {
+        tr_warn("Failed to delete backhaul default route");
+    }
+}
+
+#if MBED_CONF_APP_BACKHAUL_FAILOVER
+static void borderrouter_backhaul_secondary_phy_status_cb(uint8_t link_up, int8_t driver_id)
+{
+    arm_event_s event = {
+        .sender = br_tasklet_id,
+        .receiver = br_tasklet_id,
+        .priority = ARM_LIB_MED_PRIORITY_EVENT,
+        .event_type = APPLICATION_EVENT,
+        .event_id = NR_BACKHAUL_SECONDARY_PHY_DOWN,
+        .event_data = driver_id
+    };
+
+    if (link_up) {
+        event.event_id = NR_BACKHAUL_SECONDARY_PHY_DRIVER_READY;
+    }
+
+    dispatch_stats_event_send(&event);
+}
+
+static void backhaul_secondary_up(int8_t driver_id)
+{
+    if (backhaul_secondary_if_id != -1) {
+        return;
+    }
+
+    if (!secondary_eth_mac_api) {
+        secondary_eth_mac_api = ethernet_mac_create(driver_id);
+    }
+
+    backhaul_secondary_if_id = arm_nwk_interface_ppp_init(secondary_eth_mac_api, "ppp0");
+    if (backhaul_secondary_if_id < 0) {
+        tr_error("Secondary backhaul interface init failed");
+        backhaul_secondary_if_id = -1;
+        return;
+    }
+
+    tr_debug("Secondary backhaul interface ID: %d", backhaul_secondary_if_id);
+    arm_net_interface_set_metric(backhaul_secondary_if_id,
+                                 backhaul_failed_over ? BACKHAUL_METRIC_ACTIVE : BACKHAUL_METRIC_STANDBY);
+    arm_nwk_interface_configure_ipv6_bootstrap_set(
+        backhaul_secondary_if_id, NET_IPV6_BOOTSTRAP_AUTONOMOUS, NULL);
+    arm_nwk_interface_up(backhaul_secondary_if_id);
+}
+
+static void backhaul_secondary_down(void)
+{
+    if (backhaul_secondary_if_id == -1) {
+        return;
+    }
+
+    arm_nwk_interface_down(backhaul_secondary_if_id);
+    backhaul_secondary_if_id = -1;
+    backhaul_secondary_ready = false;
+    if (backhaul_failed_over) {
+        tr_warn("Secondary backhaul lost while failed over");
+    }
+}
+
+static bool backhaul_primary_healthy(void)
+{
+    uint8_t address[16];
+
+    return backhaul_if_id != -1 && !backhaul_link_hold_active() &&
+           net_backhaul_state == INTERFACE_CONNECTED &&
+           arm_net_address_get(backhaul_if_id, ADDR_IPV6_GP, address) == 0;
+}
+
+/**
+  * \brief Moves the default route between the backhauls.
+  *
+  * Fails over as soon as the primary is unhealthy and fails back once it
+  * has passed MBED_CONF_APP_BACKHAUL_FAILBACK_PROBES probes in a row. Only
+  * interface metrics change, so the RF side is never touched.
+  */
+static void backhaul_health_probe(void)
+{
+    if (!backhaul_primary_healthy()) {
+        primary_healthy_probes = 0;
+        if (!backhaul_failed_over && backhaul_secondary_ready) {
+            backhaul_failed_over = true;
+            if (backhaul_if_id != -1) {
+                arm_net_interface_set_metric(backhaul_if_id, BACKHAUL_METRIC_FAILED);
+            }
+            arm_net_interface_set_metric(backhaul_secondary_if_id, BACKHAUL_METRIC_ACTIVE);
+            tr_warn("Backhaul failover to ppp0");
+        }
+    } else if (backhaul_failed_over && ++primary_healthy_probes >= MBED_CONF_APP_BACKHAUL_FAILBACK_PROBES) {
+        backhaul_failed_over = false;
+        arm_net_interface_set_metric(backhaul_if_id, BACKHAUL_METRIC_ACTIVE);
+        if (backhaul_secondary_if_id != -1) {
+            arm_net_interface_set_metric(backhaul_secondary_if_id, BACKHAUL_METRIC_STANDBY);
+        }
+        tr_info("Backhaul failback to bh0");
+    }
+}
+#endif // MBED_CONF_APP_BACKHAUL_FAILOVER
+
+#ifdef MBED_CONF_APP_DEBUG_TRACE
+#if MBED_CONF_APP_DEBUG_TRACE == 1
+static void mesh_interface_stats_print(void)
+{
+    tr_info("MAC rx: %lu, tx: %lu, tx failed: %lu, CCA attempts: %lu, CCA failed: %lu",
+            (unsigned long)mac_stats.mac_rx_count, (unsigned long)mac_stats.mac_tx_count,
+            (unsigned long)mac_stats.mac_tx_failed_count, (unsigned long)mac_stats.mac_cca_attempts_count,
+            (unsigned long)mac_stats.mac_failed_cca_count);
+}
+#endif
+#endif
+
 /**
   * \brief Border Router Main Tasklet
   *
@@ -407,6 +678,10 @@ static void borderrouter_tasklet(arm_event_s *event)
 
                 tr_debug("Backhaul driver ID: %d", net_backhaul_id);
 
+                if (backhaul_link_hold_resume(br_tasklet_id)) {
+                    break;
+                }
+
                 if (backhaul_interface_up(net_backhaul_id) != 0) {
                     tr_debug("Backhaul bootstrap start failed");
                 } else {
@@ -415,14 +690,17 @@ static void borderrouter_tasklet(arm_event_s *event)
                 }
             } else if (event->event_id == NR_BACKHAUL_INTERFACE_PHY_DOWN) {
                 tr_debug("Backhaul driver ID: %d", (int8_t) event->event_data);
-                if (backhaul_interface_down() != 0) {
-                    tr_error("Backhaul interface down failed");
-                } else {
-                    tr_debug("Backhaul interface is down");
-                    backhaul_if_id = -1;
-                    net_backhaul_state = INTERFACE_IDLE_STATE;
+                if (!backhaul_link_hold_suspend(br_tasklet_id, backhaul_if_id)) {
+                    backhaul_link_lost();
                 }
             }
+#if MBED_CONF_APP_BACKHAUL_FAILOVER
+            else if (event->event_id == NR_BACKHAUL_SECONDARY_PHY_DRIVER_READY) {
+                backhaul_secondary_up((int8_t) event->event_data);
+            } else if (event->event_id == NR_BACKHAUL_SECONDARY_PHY_DOWN) {
+                backhaul_secondary_down();
+            }
+#endif
             break;
 
         case ARM_LIB_TASKLET_INIT_EVENT:
@@ -431,27 +709,73 @@ static void borderrouter_tasklet(arm_event_s *event)
 
             /* initialize the backhaul interface */
             backhaul_driver_init(borderrouter_backhaul_phy_status_cb);
+            boot_timeline_mark(BOOT_STAGE_BACKHAUL_DRIVER);
+#if MBED_CONF_APP_BACKHAUL_FAILOVER
+            backhaul_secondary_driver_init(borderrouter_backhaul_secondary_phy_status_cb);
+            dispatch_stats_timer_request(BACKHAUL_HEALTH_TIMER, ARM_LIB_SYSTEM_TIMER_EVENT, br_tasklet_id,
+                                         MBED_CONF_APP_BACKHAUL_HEALTH_INTERVAL_MS);
+#endif
+
+            multicast_groups_init(multicast_addr);
+            iphc_contexts_init();
+            airtime_window_start();
+            if (MBED_CONF_APP_RPL_ADAPTIVE_TRICKLE) {
+                trickle_controller_init(runtime_config.rpl_imin, runtime_config.rpl_idoublings, runtime_config.rpl_k,
+                                        &nwk_stats);
+                dispatch_stats_timer_request(RPL_TRICKLE_TIMER, ARM_LIB_SYSTEM_TIMER_EVENT, br_tasklet_id,
+                                             MBED_CONF_APP_RPL_TRICKLE_INTERVAL_MS);
+            }
 
             if (net_6lowpan_id < 0) {
                 tr_error("RF interface initialization failed");
                 return;
             }
             net_6lowpan_state = INTERFACE_IDLE_STATE;
-            eventOS_event_timer_request(9, ARM_LIB_SYSTEM_TIMER_EVENT, br_tasklet_id, 20000);
+            if (mesh_before_backhaul) {
+                /* Start the PAN with the configured prefix, backhaul prefix is applied later */
+                start_6lowpan(NULL);
+            }
+            dispatch_stats_timer_request(9, ARM_LIB_SYSTEM_TIMER_EVENT, br_tasklet_id, 20000);
             break;
 
         case ARM_LIB_SYSTEM_TIMER_EVENT:
-            eventOS_event_timer_cancel(event->event_id, event->receiver);
+            dispatch_stats_timer_cancel(event->event_id, event->receiver);
 
             if (event->event_id == 9) {
 #ifdef MBED_CONF_APP_DEBUG_TRACE
 #if MBED_CONF_APP_DEBUG_TRACE == 1
-                arm_print_routing_table();
-                arm_print_neigh_cache();
-                print_memory_stats();
+                if (!memory_pressure_active(MEMORY_PRESSURE_DUMPS)) {
+                    table_diff_report_start(-1);
+                    print_memory_stats();
+                    dispatch_stats_print();
+                    packet_capture_print();
+                    buffer_pools_print();
+                    memory_pressure_print();
+                    mesh_interface_stats_print();
+                    multicast_groups_print();
+                    if (MBED_CONF_APP_RPL_ADAPTIVE_TRICKLE) {
+                        trickle_controller_print();
+                    }
+                }
 #endif
 #endif
-                eventOS_event_timer_request(9, ARM_LIB_SYSTEM_TIMER_EVENT, br_tasklet_id, 20000);
+                dispatch_stats_timer_request(9, ARM_LIB_SYSTEM_TIMER_EVENT, br_tasklet_id, 20000);
+            } else if (backhaul_link_hold_expired(event->event_id)) {
+                backhaul_link_lost();
+            }
+#if MBED_CONF_APP_BACKHAUL_FAILOVER
+            else if (event->event_id == BACKHAUL_HEALTH_TIMER) {
+                backhaul_health_probe();
+                dispatch_stats_timer_request(BACKHAUL_HEALTH_TIMER, ARM_LIB_SYSTEM_TIMER_EVENT, br_tasklet_id,
+                                             MBED_CONF_APP_BACKHAUL_HEALTH_INTERVAL_MS);
+            }
+#endif
+            else if (event->event_id == RPL_AIRTIME_TIMER) {
+                airtime_window_close();
+            } else if (event->event_id == RPL_TRICKLE_TIMER) {
+                rpl_trickle_adapt();
+                dispatch_stats_timer_request(RPL_TRICKLE_TIMER, ARM_LIB_SYSTEM_TIMER_EVENT, br_tasklet_id,
+                                             MBED_CONF_APP_RPL_TRICKLE_INTERVAL_MS);
             }
             break;
 
@@ -463,15 +787,22 @@ static void borderrouter_tasklet(arm_event_s *event)
 static void start_6lowpan(const uint8_t *backhaul_address)
 {
     uint8_t p[16] = {0};
+    bool backhaul_gp_available = (arm_net_address_get(backhaul_if_id, ADDR_IPV6_GP, p) == 0);
+
+    boot_timeline_mark(BOOT_STAGE_MESH_START);
 
-    if (arm_net_address_get(backhaul_if_id, ADDR_IPV6_GP, p) == 0) {
+    if (backhaul_gp_available || mesh_before_backhaul) {
         uint32_t lifetime = 0xffffffff; // infinite
         uint8_t prefix_len = 0;
         uint8_t t_flags = 0;
         int8_t retval = -1;
 
         /* Channel list: listen to a channel (default: all channels) */
-        uint32_t channel = cfg_int(global_config, "RF_CHANNEL", 0);
+        int32_t channel = mesh_channel_get(&runtime_config);
+        if (channel < 0) {
+            tr_error("RF interface not started, RF configuration not supported");
+            return;
+        }
         tr_info("RF channel: %d", (int)channel);
         initialize_channel_list(channel);
 
@@ -492,7 +823,7 @@ static void start_6lowpan(const uint8_t *backhaul_address)
         }
 
         /* Should we use the backhaul prefix on the PAN as well? */
-        if (backhaul_address && rf_prefix_from_backhaul) {
+        if (backhaul_address && backhaul_gp_available && rf_prefix_from_backhaul) {
             memcpy(br.lowpan_nd_prefix, p, 8);
             memcpy(rpl_setup_info.DODAG_ID, br.lowpan_nd_prefix, 8);
         }
@@ -513,6 +844,9 @@ static void start_6lowpan(const uint8_t *backhaul_address)
             return;
         }
 
+        /* Configured contexts for backhaul destinations */
+        iphc_contexts_interface_add(net_6lowpan_id);
+
         // configure the RPL routing protocol for the 6LoWPAN mesh network
         if (arm_nwk_6lowpan_rpl_dodag_init(net_6lowpan_id, rpl_setup_info.DODAG_ID,
                                            &dodag_config, rpl_setup_info.rpl_instance_id,
@@ -528,17 +862,14 @@ static void start_6lowpan(const uint8_t *backhaul_address)
             /* add default route "::/0" */
             arm_nwk_6lowpan_rpl_dodag_route_update(net_6lowpan_id, rpl_setup_info.DODAG_ID,
                                                    prefix_len, t_flags, lifetime);
+
         }
 
         if (link_security_mode == NET_SEC_MODE_PANA_LINK_SECURITY) {
-            uint8_t *psk = (uint8_t *)cfg_string(global_config, "TLS_PSK_KEY", NULL);
-
-            if (!psk) {
-                tr_error("No TLS PSK key set in configuration");
-                return;
-            }
+            uint8_t psk[16];
 
-            if (arm_tls_add_psk_key(psk, cfg_int(global_config, "TLS_PSK_KEY_ID", 0)) != 0) {
+            memcpy(psk, runtime_config.tls_psk_key, sizeof(psk));
+            if (arm_tls_add_psk_key(psk, runtime_config.tls_psk_key_id) != 0) {
                 tr_error("No TLS PSK key ID set in configuration");
                 return;
             }
@@ -558,6 +889,10 @@ static void start_6lowpan(const uint8_t *backhaul_address)
             return;
         }
 
+        if (memory_pressure_downlink_start(net_6lowpan_id) != 0) {
+            tr_error("RF indirect queue sizes not accepted");
+        }
+
         retval = arm_nwk_interface_up(net_6lowpan_id);
 
         if (retval < 0) {
@@ -567,12 +902,310 @@ static void start_6lowpan(const uint8_t *backhaul_address)
 
         /* mark the RF interface active */
         net_6lowpan_state = INTERFACE_BOOTSTRAP_ACTIVE;
+        mld_proxy_mesh_ready(net_6lowpan_id);
+        metrics_exporter_mesh_ready(net_6lowpan_id);
 
-        multicast_set_parameters(10, 0, 20, 3, 75);
-        multicast_add_address(multicast_addr, 1);
+        multicast_groups_subscribe(net_6lowpan_id);
+        for (uint8_t i = 0; i < multicast_groups_count(); i++) {
+            mld_proxy_subscribe(multicast_groups_address(i));
+        }
     }
 }
 
+/**
+  * \brief Moves a running PAN to the prefix learnt from the backhaul.
+  *
+  * The DODAG keeps its ID. The new prefix is added as context 1 and as an
+  * RPL prefix, the old prefix is retired with the router lifetime so that
+  * the nodes can move over, and the ABRO version is bumped so that the nodes
+  * pick up the change.
+  */
+static void rf_prefix_update(const uint8_t *backhaul_address)
+{
+    uint8_t old_prefix[16] = {0};
+    uint8_t new_prefix[16] = {0};
+    uint8_t router_address[16];
+    int8_t retval;
+
+    memcpy(new_prefix, backhaul_address, 8);
+    if (memcmp(new_prefix, br.lowpan_nd_prefix, 8) == 0) {
+        return;
+    }
+
+    memcpy(old_prefix, br.lowpan_nd_prefix, 8);
+    memcpy(br.lowpan_nd_prefix, new_prefix, 8);
+    br.abro_version_num++;
+
+    tr_info_lazy("RF prefix update: %s", tr_ipv6_prefix(new_prefix, 64));
+
+    retval = arm_nwk_6lowpan_border_router_context_update(net_6lowpan_id, ((1 << 4) | 0x01),
+                                                          64, 0xffff, new_prefix);
+    if (retval < 0) {
+        tr_error("Setting ND context failed, retval = %d", retval);
+        return;
+    }
+
+    /* Border router address on the new prefix, same interface ID as the DODAG ID */
+    memcpy(router_address, new_prefix, 8);
+    memcpy(&router_address[8], &rpl_setup_info.DODAG_ID[8], 8);
+    arm_nwk_6lowpan_rpl_dodag_prefix_update(net_6lowpan_id, router_address, 64,
+                                            RPL_PREFIX_ROUTER_ADDRESS_FLAG, 0xffffffff);
+
+    /* Old prefix stays usable for one router lifetime while the nodes move */
+    memcpy(router_address, old_prefix, 8);
+    arm_nwk_6lowpan_rpl_dodag_prefix_update(net_6lowpan_id, router_address, 64,
+                                            RPL_PREFIX_ROUTER_ADDRESS_FLAG,
+                                            runtime_config.ra_router_lifetime);
+
+    arm_nwk_6lowpan_border_router_configure_push(net_6lowpan_id);
+    arm_nwk_6lowpan_rpl_dodag_version_increment(net_6lowpan_id);
+}
+
+static void airtime_sample_read(airtime_sample_t *sample)
+{
+    sample->bc_tx_count = mac_stats.mac_bc_tx_count;
+    sample->tx_bytes = mac_stats.mac_tx_bytes;
+}
+
+/** Starts a new airtime measurement window. */
+static void airtime_window_start(void)
+{
+    airtime_sample_read(&airtime_base);
+    dispatch_stats_timer_cancel(RPL_AIRTIME_TIMER, br_tasklet_id);
+    dispatch_stats_timer_request(RPL_AIRTIME_TIMER, ARM_LIB_SYSTEM_TIMER_EVENT, br_tasklet_id,
+                                 MBED_CONF_APP_RPL_AIRTIME_WINDOW_MS);
+}
+
+/**
+  * \brief Ends the current airtime window and starts the next one.
+  *
+  * Broadcast frames are mostly DIOs and RAs, so their count tracks the
+  * control traffic. With a DODAG update pending, the window before the
+  * update is reported against the first full window after it.
+  */
+static void airtime_window_close(void)
+{
+    airtime_sample_t now;
+
+    airtime_sample_read(&now);
+    airtime_last.bc_tx_count = now.bc_tx_count - airtime_base.bc_tx_count;
+    airtime_last.tx_bytes = now.tx_bytes - airtime_base.tx_bytes;
+
+    if (airtime_pending) {
+        airtime_pending = false;
+        tr_info("DODAG update, per %d ms: broadcast TX %lu -> %lu, TX bytes %lu -> %lu",
+                MBED_CONF_APP_RPL_AIRTIME_WINDOW_MS,
+                (unsigned long)airtime_before.bc_tx_count, (unsigned long)airtime_last.bc_tx_count,
+                (unsigned long)airtime_before.tx_bytes, (unsigned long)airtime_last.tx_bytes);
+    }
+    airtime_window_start();
+}
+
+/**
+  * \brief Reads the state of the root DODAG.
+  *
+  * \return false unless the configured instance has the configured DODAG ID
+  */
+static bool rpl_dodag_info_get(rpl_dodag_info_t *dodag_info)
+{
+    memset(dodag_info, 0, sizeof(*dodag_info));
+    if (!rpl_read_dodag_info(dodag_info, rpl_setup_info.rpl_instance_id)) {
+        return false;
+    }
+    return memcmp(dodag_info->dodag_id, rpl_setup_info.DODAG_ID, 16) == 0;
+}
+
+/* RFC 6550 section 7.2: true if lollipop counter a is newer than b */
+static bool rpl_version_newer(uint8_t a, uint8_t b)
+{
+    if (a >= 128 && b < 128) {
+        return (256 + b - a) > RPL_SEQUENCE_WINDOW;
+    }
+    if (a < 128 && b >= 128) {
+        return (256 + a - b) <= RPL_SEQUENCE_WINDOW;
+    }
+    if (a >= 128) {
+        return a > b;
+    }
+    return a != b && ((a - b) & 0x7f) < 64;
+}
+
+/**
+  * \brief Applies new DODAG parameters to the running mesh.
+  *
+  * Nanostack has no call to change the configuration of a running root
+  * DODAG, so it is removed and created again with the same DODAG ID,
+  * instance, prefix and default route. The new root starts from its initial
+  * version, which is stepped past the one the nodes know. The new version is
+  * a global repair: the nodes take the new parameters from the next DIO and
+  * keep their MAC and ND state.
+  */
+static void rpl_dodag_update(void)
+{
+    rpl_dodag_info_t dodag_info;
+    uint8_t router_address[16];
+    uint8_t old_version;
+
+    if (!rpl_dodag_info_get(&dodag_info)) {
+        tr_error("DODAG not found, not updated");
+        return;
+    }
+    old_version = dodag_info.version_num;
+
+    arm_nwk_6lowpan_rpl_dodag_remove(net_6lowpan_id);
+    if (arm_nwk_6lowpan_rpl_dodag_init(net_6lowpan_id, rpl_setup_info.DODAG_ID, &dodag_config,
+                                       rpl_setup_info.rpl_instance_id, rpl_setup_info.rpl_setups) != 0) {
+        tr_error("DODAG update failed");
+        return;
+    }
+
+    /* Same prefix and default route as before, the prefix may have moved to the backhaul one.
+     * A prefix retired by rf_prefix_update() is not advertised again. */
+    memcpy(router_address, br.lowpan_nd_prefix, 8);
+    memcpy(&router_address[8], &rpl_setup_info.DODAG_ID[8], 8);
+    arm_nwk_6lowpan_rpl_dodag_prefix_update(net_6lowpan_id, router_address, 64,
+                                            RPL_PREFIX_ROUTER_ADDRESS_FLAG, 0xffffffff);
+    arm_nwk_6lowpan_rpl_dodag_route_update(net_6lowpan_id, rpl_setup_info.DODAG_ID, 0, 0, 0xffffffff);
+
+    if (net_6lowpan_state == INTERFACE_CONNECTED) {
+        arm_nwk_6lowpan_rpl_dodag_start(net_6lowpan_id);
+    }
+
+    for (uint8_t i = 0; i < RPL_VERSION_STEPS_MAX; i++) {
+        if (rpl_dodag_info_get(&dodag_info) && rpl_version_newer(dodag_info.version_num, old_version)) {
+            break;
+        }
+        arm_nwk_6lowpan_rpl_dodag_version_increment(net_6lowpan_id);
+    }
+
+    tr_info("DODAG version %u -> %u, Imin %u, doublings %u, k %u", old_version,
+            dodag_info.version_num, dodag_config.DAG_DIO_INT_MIN, dodag_config.DAG_DIO_INT_DOUB,
+            dodag_config.DAG_DIO_REDU);
+
+    airtime_before = airtime_last;
+    airtime_pending = true;
+}
+
+/**
+  * \brief Lets the Trickle controller retune the DODAG from the network size.
+  *
+  * The chosen parameters are pushed to the running DODAG with a new DODAG
+  * version. They are not stored, a reboot starts again from the configured
+  * values.
+  */
+static void rpl_trickle_adapt(void)
+{
+    if (net_6lowpan_state != INTERFACE_CONNECTED) {
+        return;
+    }
+
+    if (!trickle_controller_update(mesh_registered_node_count(net_6lowpan_id), &nwk_stats, &runtime_config.rpl_imin,
+                                   &runtime_config.rpl_idoublings, &runtime_config.rpl_k)) {
+        return;
+    }
+    dodag_config_load();
+    rpl_dodag_update();
+    airtime_window_start();
+}
+
+/**
+  * \brief Sheds load on the mesh under memory pressure, see memory_pressure.h.
+  *
+  * New nodes are throttled by the join gate on the radio. A shortened DAO
+  * route lifetime is pushed to the running DODAG with a new DODAG version,
+  * like a Trickle level change. It is not stored.
+  */
+static bool memory_pressure_apply(uint8_t action, bool active)
+{
+    switch (action) {
+        case MEMORY_PRESSURE_JOINS:
+            return true;
+
+        case MEMORY_PRESSURE_DOWNLINK:
+            if (net_6lowpan_id >= 0 && memory_pressure_downlink_set(net_6lowpan_id, active) != 0) {
+                tr_error("RF indirect queue sizes not accepted");
+            }
+            return true;
+
+        case MEMORY_PRESSURE_LIFETIME:
+            dodag_config_load();
+            if (net_6lowpan_state == INTERFACE_CONNECTED) {
+                rpl_dodag_update();
+            }
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+/**
+  * \brief Applies a configuration change to the affected subsystems only.
+  *
+  * A new default route replaces the old one on the running backhaul. DODAG
+  * changes are pushed to the running mesh with a new DODAG version. RF
+  * changes restart the mesh interface, the backhaul stays up.
+  *
+  * \return false if the configuration is refused
+  */
+static bool config_apply(const br_config_t *config, uint8_t changed)
+{
+    bool route_active = backhaul_bootstrap_mode == NET_IPV6_BOOTSTRAP_STATIC &&
+                        net_backhaul_state == INTERFACE_CONNECTED;
+
+    if ((changed & BR_CONFIG_CHANGED_RF) && !mesh_config_valid(config)) {
+        tr_error("RF configuration not supported, change refused");
+        return false;
+    }
+
+    /* Fail closed, a DODAG that can not be read is not touched */
+    if ((changed & (BR_CONFIG_CHANGED_RF | BR_CONFIG_CHANGED_DODAG)) == BR_CONFIG_CHANGED_DODAG &&
+            (net_6lowpan_state == INTERFACE_BOOTSTRAP_ACTIVE || net_6lowpan_state == INTERFACE_CONNECTED)) {
+        rpl_dodag_info_t dodag_info;
+
+        if (!rpl_dodag_info_get(&dodag_info)) {
+            tr_error("DODAG not found, change refused");
+            return false;
+        }
+    }
+
+    if ((changed & BR_CONFIG_CHANGED_BACKHAUL) && route_active) {
+        backhaul_route_delete();
+    }
+
+    runtime_config = *config;
+
+    if (changed & BR_CONFIG_CHANGED_BACKHAUL) {
+        backhaul_route_load();
+        if (route_active) {
+            backhaul_route_add();
+        }
+    }
+
+    if (changed & BR_CONFIG_CHANGED_DODAG) {
+        dodag_config_load();
+    }
+
+    if ((changed & (BR_CONFIG_CHANGED_RF | BR_CONFIG_CHANGED_DODAG)) == BR_CONFIG_CHANGED_DODAG) {
+        if (net_6lowpan_state == INTERFACE_BOOTSTRAP_ACTIVE || net_6lowpan_state == INTERFACE_CONNECTED) {
+            rpl_dodag_update();
+        }
+        /* The window after the update starts now */
+        airtime_window_start();
+    } else if (changed & BR_CONFIG_CHANGED_RF) {
+        mesh_interface_config(runtime_config.prefix);
+        if (net_6lowpan_state == INTERFACE_BOOTSTRAP_ACTIVE || net_6lowpan_state == INTERFACE_CONNECTED) {
+            /* Nodes only take the restarted PAN's ND state from a newer ABRO */
+            br.abro_version_num++;
+            tr_info("RF interface restart for new configuration, ABRO version %u", br.abro_version_num);
+            arm_nwk_interface_down(net_6lowpan_id);
+            net_6lowpan_state = INTERFACE_IDLE_STATE;
+            start_6lowpan(net_backhaul_state == INTERFACE_CONNECTED ? backhaul_prefix : NULL);
+        }
+    }
+    return true;
+}
+
 /**
   * \brief Network state event handler.
   * \param event show network start response or current network state.
@@ -593,6 +1226,7 @@ static void app_parse_network_event(arm_event_s *event)
             }
 
             if (backhaul_if_id == event->event_id) {
+                boot_timeline_mark(BOOT_STAGE_BACKHAUL_READY);
 
                 if (gp_address_available) {
                     tr_info("Backhaul bootstrap ready, IPv6 = %s", buf);
@@ -601,42 +1235,39 @@ static void app_parse_network_event(arm_event_s *event)
                 }
 
                 if (backhaul_bootstrap_mode == NET_IPV6_BOOTSTRAP_STATIC) {
-                    uint8_t *next_hop_ptr;
-                    int8_t retval;
-                    if (memcmp(backhaul_route.next_hop, addr_unspecified, 16) == 0) {
-                        tr_info("Next hop not defined");
-                        next_hop_ptr = NULL;
-                    } else {
-                        next_hop_ptr = backhaul_route.next_hop;
-                    }
-
-                    tr_info("Backhaul default route:");
-                    tr_info("   prefix:   %s", print_ipv6_prefix(backhaul_route.prefix, backhaul_route.prefix_len));
-                    tr_info("   next hop: %s", next_hop_ptr ? print_ipv6(backhaul_route.next_hop) : "on-link");
-
-                    retval = arm_net_route_add(backhaul_route.prefix, backhaul_route.prefix_len,
-                                               next_hop_ptr, 0xffffffff, 128, backhaul_if_id);
-
-                    if (retval < 0) {
-                        tr_error("Failed to add backhaul default route, retval = %d", retval);
-                    }
+                    backhaul_route_add();
                 }
 
                 tr_info("Backhaul interface addresses:");
                 print_interface_addr(backhaul_if_id);
+                mld_proxy_backhaul_ready(backhaul_if_id);
+                metrics_exporter_backhaul_ready(backhaul_if_id);
+                packet_capture_backhaul_ready(backhaul_if_id);
+                br_config_store_port_open(backhaul_if_id);
 
                 net_backhaul_state = INTERFACE_CONNECTED;
                 if (net_6lowpan_state == INTERFACE_IDLE_STATE) {
                     //Start 6lowpan
                     start_6lowpan(p);
+                } else if (net_6lowpan_id >= 0 && gp_address_available && rf_prefix_from_backhaul) {
+                    // PAN is already running, move it to the backhaul prefix
+                    rf_prefix_update(p);
                 }
+#if MBED_CONF_APP_BACKHAUL_FAILOVER
+            } else if (backhaul_secondary_if_id == event->event_id) {
+                tr_info("Secondary backhaul bootstrap ready, IPv6 = %s", gp_address_available ? buf : "none");
+                backhaul_secondary_ready = true;
+#endif
             } else {
+                boot_timeline_mark(BOOT_STAGE_MESH_READY);
                 tr_info("RF bootstrap ready, IPv6 = %s", buf);
                 arm_nwk_6lowpan_rpl_dodag_start(net_6lowpan_id);
                 net_6lowpan_state = INTERFACE_CONNECTED;
                 tr_info("RF interface addresses:");
                 print_interface_addr(net_6lowpan_id);
                 tr_info("6LoWPAN Border Router Bootstrap Complete.");
+                mesh_scale_report_bootstrap_done(net_6lowpan_id);
+                boot_timeline_print();
             }
         }
             /* Network connection Ready */
@@ -16,6 +16,12 @@ extern "C"
  */
 void backhaul_driver_init(void (*backhaul_driver_status_cb)(uint8_t, int8_t));
 
+/**
+ * Initializes the secondary backhaul driver used for failover. MUST be
+ * implemented by the application when "backhaul-failover" is enabled.
+ */
+void backhaul_secondary_driver_init(void (*backhaul_driver_status_cb)(uint8_t, int8_t));
+
 /**
 * Trace application details
 */
@@ -29,6 +29,17 @@
 #include "common_functions.h"
 #include "thread_management_if.h"
 #include "thread_br_conn_handler.h"
+#include "mesh_scale_report.h"
+#include "boot_timeline.h"
+#include "mld_proxy.h"
+#include "metrics_exporter.h"
+#include "table_diff.h"
+#include "dispatch_stats.h"
+#include "packet_capture.h"
+#include "buffer_pools.h"
+#include "memory_pressure.h"
+#include "mac_storage.h"
+#include "nanostack_heap_region.h"
 #include "randLIB.h"
 
 #include "ns_trace.h"
@@ -36,12 +47,50 @@
 
 #define NR_BACKHAUL_INTERFACE_PHY_DRIVER_READY 2
 #define NR_BACKHAUL_INTERFACE_PHY_DOWN  3
-#define MESH_LINK_TIMEOUT 100
+#ifndef MBED_CONF_APP_THREAD_MAX_CHILD_COUNT
+#define MBED_CONF_APP_THREAD_MAX_CHILD_COUNT 32
+#endif
+
+#ifndef MBED_CONF_APP_THREAD_ROUTER_NEIGHBOURS
+#define MBED_CONF_APP_THREAD_ROUTER_NEIGHBOURS 8
+#endif
+
+#ifndef MBED_CONF_APP_THREAD_LINK_TIMEOUT
+#define MBED_CONF_APP_THREAD_LINK_TIMEOUT 100
+#endif
+
 #define MESH_METRIC 1000
-#define THREAD_MAX_CHILD_COUNT 32
+
+#ifdef MBED_CONF_APP_MAC_KEY_DESCRIPTION_TABLE_SIZE
+#define THREAD_MAC_KEY_DESCRIPTIONS MBED_CONF_APP_MAC_KEY_DESCRIPTION_TABLE_SIZE
+#else
+#define THREAD_MAC_KEY_DESCRIPTIONS 6
+#endif
+
+/* Neighbouring routers take device table entries as well as children */
+#define THREAD_NEIGHBOURS (MBED_CONF_APP_THREAD_MAX_CHILD_COUNT + MBED_CONF_APP_THREAD_ROUTER_NEIGHBOURS)
+
+#if THREAD_NEIGHBOURS > MAC_DEVICE_TABLE_MAX
+#error "thread-max-child-count and thread-router-neighbours are limited to 255 by the MAC device table"
+#endif
+
+#if MBED_CONF_APP_MAC_DEVICE_TABLE_SIZE && THREAD_NEIGHBOURS > MBED_CONF_APP_MAC_DEVICE_TABLE_SIZE
+#error "Every Thread child and router neighbour needs a MAC device table entry, raise mac-device-table-size or set it to 0"
+#endif
+
+/* Heap of one neighbour, its MAC security entries and the stack neighbour state */
+#define THREAD_NEIGHBOUR_HEAP_COST \
+    (MAC_STORAGE_NEIGHBOUR_COST(THREAD_MAC_KEY_DESCRIPTIONS) + MBED_CONF_APP_NEIGHBOUR_HEAP_COST)
+#define THREAD_NEIGHBOUR_TABLE_HEAP (THREAD_NEIGHBOURS * THREAD_NEIGHBOUR_HEAP_COST)
+
+#ifdef NANOSTACK_HEAP_SIZE
+MBED_STATIC_ASSERT(THREAD_NEIGHBOUR_TABLE_HEAP <= NANOSTACK_HEAP_SIZE / 100 * MBED_CONF_APP_MAC_HEAP_BUDGET_PERCENT,
+                   "thread-max-child-count does not fit mac-heap-budget-percent of the nanostack heap");
+#endif
 
 const uint8_t addr_unspecified[16] = {0};
 static mac_api_t *api;
+static uint8_t thread_max_child_count = MBED_CONF_APP_THREAD_MAX_CHILD_COUNT;
 static eth_mac_api_t *eth_mac_api;
 
 typedef enum {
@@ -77,6 +126,7 @@ static void mesh_network_up(void);
 static void eth_network_data_init(void);
 static net_ipv6_mode_e backhaul_bootstrap_mode = NET_IPV6_BOOTSTRAP_STATIC;
 static void borderrouter_tasklet(arm_event_s *event);
+static bool memory_pressure_apply(uint8_t action, bool active);
 
 static void print_interface_addr(int id)
 {
@@ -84,6 +134,10 @@ static void print_interface_addr(int id)
     int address_count = 0;
     char buf[128];
 
+    if (!trace_level_active(TRACE_LEVEL_INFO)) {
+        return;
+    }
+
     if (arm_net_address_list_get(id, 128, address_buf, &address_count) == 0) {
         uint8_t *t_buf = address_buf;
         for (int i = 0; i < address_count; ++i) {
@@ -109,14 +163,14 @@ static void eth_network_data_init()
     // done like this so that prefix can be left out in the dynamic case.
     const char *param = MBED_CONF_APP_BACKHAUL_PREFIX;
     stoip6(param, strlen(param), backhaul_prefix);
-    tr_info("backhaul_prefix: %s", print_ipv6(backhaul_prefix));
+    tr_info_lazy("backhaul_prefix: %s", tr_ipv6(backhaul_prefix));
 
     /* Backhaul route configuration*/
     memset(&backhaul_route, 0, sizeof(backhaul_route));
 #ifdef MBED_CONF_APP_BACKHAUL_NEXT_HOP
     param = MBED_CONF_APP_BACKHAUL_NEXT_HOP;
     stoip6(param, strlen(param), backhaul_route.next_hop);
-    tr_info("next hop: %s", print_ipv6(backhaul_route.next_hop));
+    tr_info_lazy("next hop: %s", tr_ipv6(backhaul_route.next_hop));
 #endif
     param = MBED_CONF_APP_BACKHAUL_DEFAULT_ROUTE;
     char *prefix, route_buf[255] = {0};
@@ -125,10 +179,38 @@ static void eth_network_data_init()
     prefix = strtok(route_buf, "/");
     backhaul_route.prefix_len = atoi(strtok(NULL, "/"));
     stoip6(prefix, strlen(prefix), backhaul_route.prefix);
-    tr_info("backhaul route prefix: %s", print_ipv6(backhaul_route.prefix));
+    tr_info_lazy("backhaul route prefix: %s", tr_ipv6_prefix(backhaul_route.prefix, backhaul_route.prefix_len));
 #endif
 }
 
+/**
+ * Sheds load on the Thread mesh under memory pressure, see memory_pressure.h.
+ * Thread has no DAO routes to shorten.
+ */
+static bool memory_pressure_apply(uint8_t action, bool active)
+{
+    int8_t thread_if_id = thread_br_conn_handler_thread_interface_id_get();
+
+    switch (action) {
+        case MEMORY_PRESSURE_JOINS:
+            /* Attached children stay, new ones attach to other routers */
+            if (thread_if_id >= 0 &&
+                    thread_management_max_child_count(thread_if_id, active ? 0 : thread_max_child_count) != 0) {
+                tr_error("Thread child count not accepted");
+            }
+            return true;
+
+        case MEMORY_PRESSURE_DOWNLINK:
+            if (thread_if_id >= 0 && memory_pressure_downlink_set(thread_if_id, active) != 0) {
+                tr_error("mesh0 indirect queue sizes not accepted");
+            }
+            return true;
+
+        default:
+            return false;
+    }
+}
+
 static int thread_interface_up(void)
 {
     int32_t val;
@@ -158,8 +240,16 @@ static int thread_interface_up(void)
     }
 
     // Additional thread configurations
-    thread_management_set_link_timeout(thread_if_id, MESH_LINK_TIMEOUT);
-    thread_management_max_child_count(thread_if_id, THREAD_MAX_CHILD_COUNT);
+    thread_management_set_link_timeout(thread_if_id, MBED_CONF_APP_THREAD_LINK_TIMEOUT);
+    if (thread_management_max_child_count(thread_if_id, thread_max_child_count) != 0) {
+        tr_error("Thread child count %u not accepted", thread_max_child_count);
+    }
+    if (memory_pressure_active(MEMORY_PRESSURE_JOINS)) {
+        memory_pressure_apply(MEMORY_PRESSURE_JOINS, true);
+    }
+    if (memory_pressure_downlink_start(thread_if_id) != 0) {
+        tr_error("mesh0 indirect queue sizes not accepted");
+    }
 
     val = arm_nwk_interface_up(thread_if_id);
     if (val != 0) {
@@ -226,6 +316,7 @@ static void network_interface_event_handler(arm_event_s *event)
         case (ARM_NWK_BOOTSTRAP_READY): { // Interface configured Bootstrap is ready
 
             connectStatus = true;
+            boot_timeline_mark(BOOT_STAGE_BACKHAUL_READY);
             tr_info("BR interface_id: %d", thread_br_conn_handler_eth_interface_id_get());
             if (-1 != thread_br_conn_handler_eth_interface_id_get()) {
                 // metric set to high priority
@@ -240,9 +331,9 @@ static void network_interface_event_handler(arm_event_s *event)
                     } else {
                         next_hop_ptr = backhaul_route.next_hop;
                     }
-                    tr_debug("Default route prefix: %s/%d", print_ipv6(backhaul_route.prefix),
-                             backhaul_route.prefix_len);
-                    tr_debug("Default route next hop: %s", print_ipv6(backhaul_route.next_hop));
+                    tr_debug_lazy("Default route: %s via %s",
+                                  tr_ipv6_prefix(backhaul_route.prefix, backhaul_route.prefix_len),
+                                  tr_ipv6(backhaul_route.next_hop));
                     arm_net_route_add(backhaul_route.prefix,
                                       backhaul_route.prefix_len,
                                       next_hop_ptr, 0xffffffff, 128,
@@ -250,6 +341,9 @@ static void network_interface_event_handler(arm_event_s *event)
                 }
                 tr_info("Backhaul interface addresses:");
                 print_interface_addr(thread_br_conn_handler_eth_interface_id_get());
+                mld_proxy_backhaul_ready(thread_br_conn_handler_eth_interface_id_get());
+                metrics_exporter_backhaul_ready(thread_br_conn_handler_eth_interface_id_get());
+                packet_capture_backhaul_ready(thread_br_conn_handler_eth_interface_id_get());
                 thread_br_conn_handler_ethernet_connection_update(connectStatus);
             }
             break;
@@ -296,6 +390,7 @@ void thread_interface_event_handler(arm_event_s *event)
     switch (status) {
         case (ARM_NWK_BOOTSTRAP_READY): { // Interface configured Bootstrap is ready
             connectStatus = true;
+            boot_timeline_mark(BOOT_STAGE_MESH_READY);
             tr_info("Thread bootstrap ready");
 
             if (arm_net_interface_set_metric(thread_br_conn_handler_thread_interface_id_get(), MESH_METRIC) != 0) {
@@ -304,6 +399,10 @@ void thread_interface_event_handler(arm_event_s *event)
 
             tr_info("RF interface addresses:");
             print_interface_addr(thread_br_conn_handler_thread_interface_id_get());
+            mld_proxy_mesh_ready(thread_br_conn_handler_thread_interface_id_get());
+            metrics_exporter_mesh_ready(thread_br_conn_handler_thread_interface_id_get());
+            mesh_scale_report_bootstrap_done(thread_br_conn_handler_thread_interface_id_get());
+            boot_timeline_print();
 
             break;
         }
@@ -321,6 +420,7 @@ void thread_interface_event_handler(arm_event_s *event)
 static void mesh_network_up()
 {
     tr_debug("Create Mesh Interface");
+    boot_timeline_mark(BOOT_STAGE_MESH_START);
 
     int status;
     int8_t thread_if_id;
@@ -356,10 +456,20 @@ static void mesh_network_up()
 void thread_rf_init()
 {
     mac_description_storage_size_t storage_sizes;
-    storage_sizes.key_lookup_size = 1;
-    storage_sizes.key_usage_size = 1;
-    storage_sizes.device_decription_table_size = 32;
-    storage_sizes.key_description_table_size = 6;
+    uint8_t child_entries;
+
+    mac_storage_sizes_get(&storage_sizes, THREAD_MAC_KEY_DESCRIPTIONS, 1, 1);
+    /* The router neighbours are reserved first, children get the rest */
+    child_entries = storage_sizes.device_decription_table_size > MBED_CONF_APP_THREAD_ROUTER_NEIGHBOURS ?
+                    storage_sizes.device_decription_table_size - MBED_CONF_APP_THREAD_ROUTER_NEIGHBOURS : 0;
+    if (child_entries < thread_max_child_count) {
+        tr_warn("MAC device table holds %u neighbours, %u reserved for routers, Thread children limited to %u",
+                storage_sizes.device_decription_table_size, MBED_CONF_APP_THREAD_ROUTER_NEIGHBOURS, child_entries);
+        thread_max_child_count = child_entries;
+    }
+    tr_info("Thread children %u, router neighbours %u, link timeout %u s, neighbour table heap %lu bytes",
+            thread_max_child_count, MBED_CONF_APP_THREAD_ROUTER_NEIGHBOURS, MBED_CONF_APP_THREAD_LINK_TIMEOUT,
+            (unsigned long)(thread_max_child_count + MBED_CONF_APP_THREAD_ROUTER_NEIGHBOURS) * THREAD_NEIGHBOUR_HEAP_COST);
 
     int8_t rf_driver_id = rf_device_register();
     MBED_ASSERT(rf_driver_id >= 0);
@@ -367,22 +477,32 @@ void thread_rf_init()
         randLIB_seed_random();
 
         if (!api) {
+            uint32_t heap_before = mac_storage_heap_allocated();
             api = ns_sw_mac_create(rf_driver_id, &storage_sizes);
+            mac_storage_report(&storage_sizes, heap_before);
+            packet_capture_tap(rf_driver_id, "mesh0", CAPTURE_IF_MESH);
         }
     }
 }
 
 void border_router_tasklet_start(void)
 {
+    /* Before the drivers are tapped */
+    packet_capture_start();
     thread_rf_init();
     protocol_stats_start(&nwk_stats);
+    metrics_exporter_start(&nwk_stats);
+    mesh_scale_report_start();
+    dispatch_stats_start();
+    memory_pressure_start(memory_pressure_apply);
 
-    eventOS_event_handler_create(
+    dispatch_stats_handler_create(
         &borderrouter_tasklet,
         ARM_LIB_TASKLET_INIT_EVENT);
 }
 
 
+
 static void borderrouter_backhaul_phy_status_cb(uint8_t link_up, int8_t driver_id)
 {
     arm_event_s event = {
@@ -398,7 +518,7 @@ static void borderrouter_backhaul_phy_status_cb(uint8_t link_up, int8_t driver_i
         event.event_id = NR_BACKHAUL_INTERFACE_PHY_DRIVER_READY;
     }
 
-    eventOS_event_send(&event);
+    dispatch_stats_event_send(&event);
 }
 
 static int backhaul_interface_up(int8_t driver_id)
@@ -412,6 +532,7 @@ static int backhaul_interface_up(int8_t driver_id)
 
         if (!eth_mac_api) {
             eth_mac_api = ethernet_mac_create(driver_id);
+            packet_capture_tap(driver_id, "bh0", CAPTURE_IF_BACKHAUL);
         }
 
         backhaul_if_id = arm_nwk_interface_ethernet_init(eth_mac_api, "bh0");
@@ -487,6 +608,10 @@ static void borderrouter_tasklet(arm_event_s *event)
 
                 tr_debug("Backhaul driver ID: %d", net_backhaul_id);
 
+                if (backhaul_link_hold_resume(br_tasklet_id)) {
+                    break;
+                }
+
                 if (backhaul_interface_up(net_backhaul_id) != 0) {
                     tr_debug("Backhaul bootstrap start failed");
                 } else {
@@ -494,8 +619,8 @@ static void borderrouter_tasklet(arm_event_s *event)
                 }
             } else if (event->event_id == NR_BACKHAUL_INTERFACE_PHY_DOWN) {
                 tr_debug("Backhaul driver ID: %d", (int8_t) event->event_data);
-                if (backhaul_interface_down() != 0) {
-                } else {
+                if (!backhaul_link_hold_suspend(br_tasklet_id, thread_br_conn_handler_eth_interface_id_get()) &&
+                        backhaul_interface_down() == 0) {
                     tr_debug("Backhaul interface is down");
                 }
             }
@@ -507,23 +632,33 @@ static void borderrouter_tasklet(arm_event_s *event)
             thread_br_conn_handler_init();
             eth_network_data_init();
             backhaul_driver_init(borderrouter_backhaul_phy_status_cb);
+            boot_timeline_mark(BOOT_STAGE_BACKHAUL_DRIVER);
             mesh_network_up();
-            eventOS_event_timer_request(9, ARM_LIB_SYSTEM_TIMER_EVENT, br_tasklet_id, 20000);
+            dispatch_stats_timer_request(9, ARM_LIB_SYSTEM_TIMER_EVENT, br_tasklet_id, 20000);
             break;
 
         case ARM_LIB_SYSTEM_TIMER_EVENT:
-            eventOS_event_timer_cancel(event->event_id, event->receiver);
+            dispatch_stats_timer_cancel(event->event_id, event->receiver);
 
             if (event->event_id == 9) {
 #if MBED_CONF_APP_DEBUG_TRACE
-                arm_print_routing_table();
-                arm_print_neigh_cache();
-                print_memory_stats();
-                // Trace interface addresses. This trace can be removed if nanostack prints added/removed
-                // addresses.
-                print_interface_addresses();
+                if (!memory_pressure_active(MEMORY_PRESSURE_DUMPS)) {
+                    table_diff_report_start(thread_br_conn_handler_thread_interface_id_get());
+                    print_memory_stats();
+                    dispatch_stats_print();
+                    packet_capture_print();
+                    buffer_pools_print();
+                    memory_pressure_print();
+                    // Trace interface addresses. This trace can be removed if nanostack prints added/removed
+                    // addresses.
+                    print_interface_addresses();
+                }
 #endif
-                eventOS_event_timer_request(9, ARM_LIB_SYSTEM_TIMER_EVENT, br_tasklet_id, 20000);
+                dispatch_stats_timer_request(9, ARM_LIB_SYSTEM_TIMER_EVENT, br_tasklet_id, 20000);
+            } else if (backhaul_link_hold_expired(event->event_id)) {
+                if (backhaul_interface_down() == 0) {
+                    tr_debug("Backhaul interface is down");
+                }
             }
             break;
 
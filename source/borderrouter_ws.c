@@ -28,6 +28,16 @@
 #include "sw_mac.h"
 #include "nwk_stats_api.h"
 #include "randLIB.h"
+#include "mesh_scale_report.h"
+#include "boot_timeline.h"
+#include "mld_proxy.h"
+#include "metrics_exporter.h"
+#include "table_diff.h"
+#include "dispatch_stats.h"
+#include "packet_capture.h"
+#include "buffer_pools.h"
+#include "memory_pressure.h"
+#include "mac_storage.h"
 #ifdef MBED_CONF_APP_CERTIFICATE_HEADER
 #include MBED_CONF_APP_CERTIFICATE_HEADER
 #endif
@@ -121,6 +131,7 @@ static ws_config_t ws_conf;
 static void mesh_network_up()
 {
     tr_debug("Create Mesh Interface");
+    boot_timeline_mark(BOOT_STAGE_MESH_START);
 
     int status;
     int8_t wisun_if_id = ws_br_handler.ws_interface_id;
@@ -157,14 +168,14 @@ static void eth_network_data_init()
     // done like this so that prefix can be left out in the dynamic case.
     const char *param = MBED_CONF_APP_BACKHAUL_PREFIX;
     stoip6(param, strlen(param), backhaul_prefix);
-    tr_info("backhaul_prefix: %s", print_ipv6(backhaul_prefix));
+    tr_info_lazy("backhaul_prefix: %s", tr_ipv6(backhaul_prefix));
 
     /* Backhaul route configuration*/
     memset(&backhaul_route, 0, sizeof(backhaul_route));
 #ifdef MBED_CONF_APP_BACKHAUL_NEXT_HOP
     param = MBED_CONF_APP_BACKHAUL_NEXT_HOP;
     stoip6(param, strlen(param), backhaul_route.next_hop);
-    tr_info("next hop: %s", print_ipv6(backhaul_route.next_hop));
+    tr_info_lazy("next hop: %s", tr_ipv6(backhaul_route.next_hop));
 #endif
     param = MBED_CONF_APP_BACKHAUL_DEFAULT_ROUTE;
     char *prefix, route_buf[255] = {0};
@@ -173,7 +184,7 @@ static void eth_network_data_init()
     prefix = strtok(route_buf, "/");
     backhaul_route.prefix_len = atoi(strtok(NULL, "/"));
     stoip6(prefix, strlen(prefix), backhaul_route.prefix);
-    tr_info("backhaul route prefix: %s", print_ipv6(backhaul_route.prefix));
+    tr_info_lazy("backhaul route prefix: %s", tr_ipv6_prefix(backhaul_route.prefix, backhaul_route.prefix_len));
 #endif
 }
 
@@ -237,17 +248,18 @@ void load_config(void)
 void wisun_rf_init()
 {
     mac_description_storage_size_t storage_sizes;
-    storage_sizes.device_decription_table_size = 32;
-    storage_sizes.key_description_table_size = 4;
-    storage_sizes.key_lookup_size = 1;
-    storage_sizes.key_usage_size = 1;
+    mac_storage_sizes_get(&storage_sizes, 4, 1, 1);
 
     int8_t rf_driver_id = rf_device_register();
     MBED_ASSERT(rf_driver_id >= 0);
     if (rf_driver_id >= 0) {
         randLIB_seed_random();
         if (!mac_api) {
+            uint32_t heap_before = mac_storage_heap_allocated();
             mac_api = ns_sw_mac_create(rf_driver_id, &storage_sizes);
+            mac_storage_report(&storage_sizes, heap_before);
+            memory_pressure_join_gate(rf_driver_id);
+            packet_capture_tap(rf_driver_id, "mesh0", CAPTURE_IF_MESH);
         }
 
         ws_br_handler.ws_interface_id = arm_nwk_interface_lowpan_init(mac_api, ws_conf.network_name);
@@ -346,20 +358,39 @@ static int wisun_interface_up(void)
     return 0;
 }
 
+/**
+ * Sheds load on the Wi-SUN mesh under memory pressure, see memory_pressure.h.
+ * New nodes are throttled by the join gate on the radio. Wi-SUN nodes are
+ * not sleepy and the stack keeps the RPL lifetimes, so the other actions
+ * are not available.
+ */
+static bool memory_pressure_apply(uint8_t action, bool active)
+{
+    (void)active;
+    return action == MEMORY_PRESSURE_JOINS;
+}
+
 void border_router_tasklet_start(void)
 {
     ws_br_handler.ws_interface_id = -1;
     ws_br_handler.net_interface_id = -1;
 
     load_config();
+    /* Before the drivers are tapped */
+    packet_capture_start();
     wisun_rf_init();
     protocol_stats_start(&nwk_stats);
+    metrics_exporter_start(&nwk_stats);
+    mesh_scale_report_start();
+    dispatch_stats_start();
+    memory_pressure_start(memory_pressure_apply);
 
-    eventOS_event_handler_create(
+    dispatch_stats_handler_create(
         &borderrouter_tasklet,
         ARM_LIB_TASKLET_INIT_EVENT);
 }
 
+
 #undef ETH
 #undef SLIP
 #undef EMAC
@@ -380,6 +411,7 @@ static int backhaul_interface_up(int8_t driver_id)
 
     if (!eth_mac_api) {
         eth_mac_api = ethernet_mac_create(driver_id);
+        packet_capture_tap(driver_id, "bh0", CAPTURE_IF_BACKHAUL);
     }
 
 #if MBED_CONF_APP_BACKHAUL_DRIVER == CELL
@@ -432,6 +464,10 @@ static void print_interface_addr(int id)
     int address_count = 0;
     char buf[128];
 
+    if (!trace_level_active(TRACE_LEVEL_INFO)) {
+        return;
+    }
+
     if (arm_net_address_list_get(id, 128, address_buf, &address_count) == 0) {
         uint8_t *t_buf = address_buf;
         for (int i = 0; i < address_count; ++i) {
@@ -482,13 +518,18 @@ static void borderrouter_tasklet(arm_event_s *event)
             if (event->event_id == NR_BACKHAUL_INTERFACE_PHY_DRIVER_READY) {
                 int8_t net_backhaul_id = (int8_t) event->event_data;
 
+                if (backhaul_link_hold_resume(br_tasklet_id)) {
+                    break;
+                }
+
                 if (backhaul_interface_up(net_backhaul_id) != 0) {
                     tr_debug("Backhaul bootstrap start failed");
                 } else {
                     tr_debug("Backhaul bootstrap started");
                 }
             } else if (event->event_id == NR_BACKHAUL_INTERFACE_PHY_DOWN) {
-                if (backhaul_interface_down() == 0) {
+                if (!backhaul_link_hold_suspend(br_tasklet_id, ws_br_handler.net_interface_id) &&
+                        backhaul_interface_down() == 0) {
                     tr_debug("Backhaul interface is down");
                 }
             }
@@ -498,23 +539,33 @@ static void borderrouter_tasklet(arm_event_s *event)
             br_tasklet_id = event->receiver;
             eth_network_data_init();
             backhaul_driver_init(borderrouter_backhaul_phy_status_cb);
+            boot_timeline_mark(BOOT_STAGE_BACKHAUL_DRIVER);
             mesh_network_up();
-            eventOS_event_timer_request(9, ARM_LIB_SYSTEM_TIMER_EVENT, br_tasklet_id, 20000);
+            dispatch_stats_timer_request(9, ARM_LIB_SYSTEM_TIMER_EVENT, br_tasklet_id, 20000);
             break;
 
         case ARM_LIB_SYSTEM_TIMER_EVENT:
-            eventOS_event_timer_cancel(event->event_id, event->receiver);
+            dispatch_stats_timer_cancel(event->event_id, event->receiver);
 
             if (event->event_id == 9) {
 #if MBED_CONF_APP_DEBUG_TRACE
-                arm_print_routing_table();
-                arm_print_neigh_cache();
-                print_memory_stats();
-                // Trace interface addresses. This trace can be removed if nanostack prints added/removed
-                // addresses.
-                print_interface_addresses();
+                if (!memory_pressure_active(MEMORY_PRESSURE_DUMPS)) {
+                    table_diff_report_start(ws_br_handler.ws_interface_id);
+                    print_memory_stats();
+                    dispatch_stats_print();
+                    packet_capture_print();
+                    buffer_pools_print();
+                    memory_pressure_print();
+                    // Trace interface addresses. This trace can be removed if nanostack prints added/removed
+                    // addresses.
+                    print_interface_addresses();
+                }
 #endif
-                eventOS_event_timer_request(9, ARM_LIB_SYSTEM_TIMER_EVENT, br_tasklet_id, 20000);
+                dispatch_stats_timer_request(9, ARM_LIB_SYSTEM_TIMER_EVENT, br_tasklet_id, 20000);
+            } else if (backhaul_link_hold_expired(event->event_id)) {
+                if (backhaul_interface_down() == 0) {
+                    tr_debug("Backhaul interface is down");
+                }
             }
             break;
 
@@ -539,7 +590,7 @@ static void borderrouter_backhaul_phy_status_cb(uint8_t link_up, int8_t driver_i
         event.event_id = NR_BACKHAUL_INTERFACE_PHY_DOWN;
     }
 
-    eventOS_event_send(&event);
+    dispatch_stats_event_send(&event);
 }
 
 // ethernet interface
@@ -549,6 +600,7 @@ static void network_interface_event_handler(arm_event_s *event)
     switch (status) {
         case (ARM_NWK_BOOTSTRAP_READY): { // Interface configured Bootstrap is ready
 
+            boot_timeline_mark(BOOT_STAGE_BACKHAUL_READY);
             tr_info("BR interface_id: %d", ws_br_handler.net_interface_id);
             if (-1 != ws_br_handler.net_interface_id) {
                 // metric set to high priority
@@ -566,9 +618,9 @@ static void network_interface_event_handler(arm_event_s *event)
                     } else {
                         next_hop_ptr = backhaul_route.next_hop;
                     }
-                    tr_debug("Default route prefix: %s/%d", print_ipv6(backhaul_route.prefix),
-                             backhaul_route.prefix_len);
-                    tr_debug("Default route next hop: %s", print_ipv6(backhaul_route.next_hop));
+                    tr_debug_lazy("Default route: %s via %s",
+                                  tr_ipv6_prefix(backhaul_route.prefix, backhaul_route.prefix_len),
+                                  tr_ipv6(backhaul_route.next_hop));
                     arm_net_route_add(backhaul_route.prefix,
                                       backhaul_route.prefix_len,
                                       next_hop_ptr, 0xffffffff, 128,
@@ -576,6 +628,9 @@ static void network_interface_event_handler(arm_event_s *event)
                 }
                 tr_info("Backhaul interface addresses:");
                 print_interface_addr(ws_br_handler.net_interface_id);
+                mld_proxy_backhaul_ready(ws_br_handler.net_interface_id);
+                metrics_exporter_backhaul_ready(ws_br_handler.net_interface_id);
+                packet_capture_backhaul_ready(ws_br_handler.net_interface_id);
             }
             break;
         }
@@ -619,6 +674,7 @@ static void wisun_interface_event_handler(arm_event_s *event)
     arm_nwk_interface_status_type_e status = (arm_nwk_interface_status_type_e)event->event_data;
     switch (status) {
         case (ARM_NWK_BOOTSTRAP_READY): { // Interface configured Bootstrap is ready
+            boot_timeline_mark(BOOT_STAGE_MESH_READY);
             tr_info("Wisun bootstrap ready");
 
             if (arm_net_interface_set_metric(ws_br_handler.ws_interface_id, MESH_METRIC) != 0) {
@@ -627,6 +683,10 @@ static void wisun_interface_event_handler(arm_event_s *event)
 
             tr_info("RF interface addresses:");
             print_interface_addr(ws_br_handler.ws_interface_id);
+            mld_proxy_mesh_ready(ws_br_handler.ws_interface_id);
+            metrics_exporter_mesh_ready(ws_br_handler.ws_interface_id);
+            mesh_scale_report_bootstrap_done(ws_br_handler.ws_interface_id);
+            boot_timeline_print();
 
             break;
         }
@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#define LOWPAN_ND 0
+#define THREAD 1
+#define LOWPAN_WS 2
+#if MBED_CONF_APP_MESH_MODE == LOWPAN_ND
+
+#include <stddef.h>
+#include <limits>
+#include "br_config.h"
+
+#ifndef MBED_CONF_APP_MESH_BEFORE_BACKHAUL
+#define MBED_CONF_APP_MESH_BEFORE_BACKHAUL 0
+#endif
+
+#define STR_HELPER(x) #x
+#define STR(x) STR_HELPER(x)
+
+namespace {
+
+struct ip6_literal {
+    uint8_t addr[16];
+    bool valid;
+};
+
+struct route_literal {
+    br_route_config_t route;
+    bool valid;
+};
+
+constexpr size_t str_len(const char *s)
+{
+    size_t len = 0;
+    while (s[len]) {
+        len++;
+    }
+    return len;
+}
+
+constexpr bool str_equal(const char *a, const char *b)
+{
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+constexpr int hex_value(char c)
+{
+    return (c >= '0' && c <= '9') ? c - '0' :
+           (c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+           (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+}
+
+/* Parses a textual IPv6 address (RFC 4291 2.2 forms 1 and 2) */
+constexpr ip6_literal parse_ip6(const char *s, size_t len)
+{
+    ip6_literal result = {};
+    uint16_t head[8] = {};
+    uint16_t tail[8] = {};
+    int head_count = 0;
+    int tail_count = 0;
+    bool compressed = false;
+    size_t i = 0;
+
+    if (len >= 2 && s[0] == ':' && s[1] == ':') {
+        compressed = true;
+        i = 2;
+    } else if (len == 0 || s[0] == ':') {
+        return result;
+    }
+
+    while (i < len) {
+        uint32_t value = 0;
+        int digits = 0;
+
+        while (i < len && hex_value(s[i]) >= 0) {
+            value = value * 16 + hex_value(s[i]);
+            digits++;
+            i++;
+        }
+        if (digits == 0 || digits > 4 || head_count + tail_count == 8) {
+            return result;
+        }
+        if (compressed) {
+            tail[tail_count++] = value;
+        } else {
+            head[head_count++] = value;
+        }
+        if (i == len) {
+            break;
+        }
+        if (s[i++] != ':' || i == len) {
+            return result;
+        }
+        if (s[i] == ':') {
+            if (compressed) {
+                return result;
+            }
+            compressed = true;
+            i++;
+        }
+    }
+
+    if (compressed ? head_count + tail_count > 7 : head_count != 8) {
+        return result;
+    }
+
+    for (int n = 0; n < head_count; n++) {
+        result.addr[2 * n] = head[n] >> 8;
+        result.addr[2 * n + 1] = head[n];
+    }
+    for (int n = 0; n < tail_count; n++) {
+        int word = 8 - tail_count + n;
+        result.addr[2 * word] = tail[n] >> 8;
+        result.addr[2 * word + 1] = tail[n];
+    }
+    result.valid = true;
+    return result;
+}
+
+constexpr ip6_literal parse_ip6(const char *s)
+{
+    return parse_ip6(s, str_len(s));
+}
+
+/* Empty string is the unspecified address, for optional settings */
+constexpr ip6_literal parse_optional_ip6(const char *s)
+{
+    return str_len(s) ? parse_ip6(s) : ip6_literal{{}, true};
+}
+
+/* Parses "prefix/length" */
+constexpr route_literal parse_route(const char *s)
+{
+    route_literal result = {};
+    size_t len = str_len(s);
+    size_t slash = 0;
+    uint32_t prefix_len = 0;
+
+    while (slash < len && s[slash] != '/') {
+        slash++;
+    }
+    if (slash == len || slash + 1 == len || len - slash > 4) {
+        return result;
+    }
+    for (size_t i = slash + 1; i < len; i++) {
+        if (s[i] < '0' || s[i] > '9') {
+            return result;
+        }
+        prefix_len = prefix_len * 10 + (s[i] - '0');
+    }
+
+    ip6_literal prefix = parse_ip6(s, slash);
+    if (!prefix.valid || prefix_len > 128) {
+        return result;
+    }
+    for (int i = 0; i < 16; i++) {
+        result.route.prefix[i] = prefix.addr[i];
+    }
+    result.route.prefix_len = prefix_len;
+    result.valid = true;
+    return result;
+}
+
+template <typename T>
+constexpr bool fits(long long value)
+{
+    return value >= std::numeric_limits<T>::min() && value <= std::numeric_limits<T>::max();
+}
+
+constexpr uint8_t psk_key[] = MBED_CONF_APP_PSK_KEY;
+constexpr uint8_t tls_psk_key[] = MBED_CONF_APP_TLS_PSK_KEY;
+
+constexpr const char *security_mode = STR(MBED_CONF_APP_SECURITY_MODE);
+constexpr const char *pana_mode = STR(MBED_CONF_APP_PANA_MODE);
+constexpr const char *network_id = STR(MBED_CONF_APP_NETWORK_ID);
+
+constexpr ip6_literal prefix = parse_ip6(STR(MBED_CONF_APP_PREFIX));
+constexpr ip6_literal backhaul_prefix = parse_optional_ip6(STR(MBED_CONF_APP_BACKHAUL_PREFIX));
+constexpr ip6_literal backhaul_next_hop = parse_optional_ip6(STR(MBED_CONF_APP_BACKHAUL_NEXT_HOP));
+constexpr ip6_literal multicast_addr = parse_ip6(STR(MBED_CONF_APP_MULTICAST_ADDR));
+constexpr route_literal backhaul_default_route = parse_route(STR(MBED_CONF_APP_BACKHAUL_DEFAULT_ROUTE));
+
+static_assert(prefix.valid, "\"prefix\" is not an IPv6 address");
+static_assert(backhaul_prefix.valid, "\"backhaul-prefix\" is not an IPv6 address");
+static_assert(backhaul_next_hop.valid, "\"backhaul-next-hop\" is not an IPv6 address");
+static_assert(multicast_addr.valid && multicast_addr.addr[0] == 0xff, "\"multicast-addr\" is not an IPv6 multicast address");
+static_assert(backhaul_default_route.valid, "\"backhaul-default-route\" is not an IPv6 prefix/length");
+
+static_assert(str_equal(security_mode, "NONE") || str_equal(security_mode, "PSK") || str_equal(security_mode, "PANA"),
+              "\"security-mode\" must be NONE, PSK or PANA");
+static_assert(str_equal(pana_mode, "") || str_equal(pana_mode, "PSK") || str_equal(pana_mode, "ECC") ||
+              str_equal(pana_mode, "ECC+PSK"), "\"pana-mode\" must be PSK, ECC or ECC+PSK");
+static_assert(sizeof(psk_key) == 16, "\"psk-key\" must be 16 bytes");
+static_assert(sizeof(tls_psk_key) == 16, "\"tls-psk-key\" must be 16 bytes");
+static_assert(str_len(network_id) <= 16, "\"network-id\" is longer than 16 characters");
+
+static_assert(fits<uint16_t>(MBED_CONF_APP_PAN_ID) && MBED_CONF_APP_PAN_ID != 0xffff, "\"pan-id\" out of range");
+static_assert(fits<uint16_t>(MBED_CONF_APP_SHORT_MAC_ADDRESS), "\"short-mac-address\" out of range");
+static_assert(MBED_CONF_APP_RF_CHANNEL_PAGE != 0 || MBED_CONF_APP_RF_CHANNEL <= 26, "\"rf-channel\" out of range");
+static_assert(fits<uint8_t>(MBED_CONF_APP_RF_CHANNEL) && fits<uint8_t>(MBED_CONF_APP_RF_CHANNEL_PAGE),
+              "RF channel settings out of range");
+static_assert(fits<uint32_t>(MBED_CONF_APP_RF_CHANNEL_MASK), "\"rf-channel-mask\" out of range");
+static_assert(fits<uint16_t>(MBED_CONF_APP_RA_ROUTER_LIFETIME), "\"ra-router-lifetime\" out of range");
+static_assert(fits<uint8_t>(MBED_CONF_APP_BEACON_PROTOCOL_ID), "\"beacon-protocol-id\" out of range");
+static_assert(fits<uint8_t>(MBED_CONF_APP_RPL_INSTANCE_ID) && fits<uint8_t>(MBED_CONF_APP_RPL_IDOUBLINGS) &&
+              fits<uint8_t>(MBED_CONF_APP_RPL_IMIN) && fits<uint8_t>(MBED_CONF_APP_RPL_K) &&
+              fits<uint8_t>(MBED_CONF_APP_RPL_PCS) && fits<uint8_t>(MBED_CONF_APP_RPL_OCP),
+              "RPL setting out of range");
+static_assert(fits<uint16_t>(MBED_CONF_APP_RPL_MAX_RANK_INC) && fits<uint16_t>(MBED_CONF_APP_RPL_MIN_HOP_RANK_INC) &&
+              fits<uint16_t>(MBED_CONF_APP_RPL_DEFAULT_LIFETIME) && fits<uint16_t>(MBED_CONF_APP_RPL_LIFETIME_UNIT),
+              "RPL setting out of range");
+static_assert(fits<uint8_t>(MBED_CONF_APP_PSK_KEY_ID) && fits<uint16_t>(MBED_CONF_APP_TLS_PSK_KEY_ID),
+              "Key ID out of range");
+
+constexpr br_config_t make_config()
+{
+    br_config_t config = {};
+
+    for (int i = 0; i < 16; i++) {
+        config.prefix[i] = prefix.addr[i];
+        config.multicast_addr[i] = multicast_addr.addr[i];
+        config.backhaul_prefix[i] = i < 8 ? backhaul_prefix.addr[i] : 0;
+        config.backhaul_next_hop[i] = backhaul_next_hop.addr[i];
+        config.psk_key[i] = psk_key[i];
+        config.tls_psk_key[i] = tls_psk_key[i];
+    }
+    for (size_t i = 0; i < str_len(network_id); i++) {
+        config.network_id[i] = network_id[i];
+    }
+    config.backhaul_default_route = backhaul_default_route.route;
+
+    config.pan_id = MBED_CONF_APP_PAN_ID;
+    config.short_mac_address = MBED_CONF_APP_SHORT_MAC_ADDRESS;
+    config.rf_channel = MBED_CONF_APP_RF_CHANNEL;
+    config.rf_channel_page = MBED_CONF_APP_RF_CHANNEL_PAGE;
+    config.rf_channel_mask = MBED_CONF_APP_RF_CHANNEL_MASK;
+    config.ra_router_lifetime = MBED_CONF_APP_RA_ROUTER_LIFETIME;
+    config.beacon_protocol_id = MBED_CONF_APP_BEACON_PROTOCOL_ID;
+    config.prefix_from_backhaul = MBED_CONF_APP_PREFIX_FROM_BACKHAUL;
+    config.mesh_before_backhaul = MBED_CONF_APP_MESH_BEFORE_BACKHAUL;
+
+    config.rpl_instance_id = MBED_CONF_APP_RPL_INSTANCE_ID;
+    config.rpl_idoublings = MBED_CONF_APP_RPL_IDOUBLINGS;
+    config.rpl_imin = MBED_CONF_APP_RPL_IMIN;
+    config.rpl_k = MBED_CONF_APP_RPL_K;
+    config.rpl_max_rank_inc = MBED_CONF_APP_RPL_MAX_RANK_INC;
+    config.rpl_min_hop_rank_inc = MBED_CONF_APP_RPL_MIN_HOP_RANK_INC;
+    config.rpl_default_lifetime = MBED_CONF_APP_RPL_DEFAULT_LIFETIME;
+    config.rpl_lifetime_unit = MBED_CONF_APP_RPL_LIFETIME_UNIT;
+    config.rpl_pcs = MBED_CONF_APP_RPL_PCS;
+    config.rpl_ocp = MBED_CONF_APP_RPL_OCP;
+
+    config.backhaul_dynamic_bootstrap = MBED_CONF_APP_BACKHAUL_DYNAMIC_BOOTSTRAP;
+
+    config.security_mode = str_equal(security_mode, "PSK") ? NET_SEC_MODE_PSK_LINK_SECURITY :
+                           str_equal(security_mode, "PANA") ? NET_SEC_MODE_PANA_LINK_SECURITY :
+                           NET_SEC_MODE_NO_LINK_SECURITY;
+    config.pana_suite = str_equal(pana_mode, "ECC") ? NET_TLS_ECC_CIPHER :
+                        str_equal(pana_mode, "ECC+PSK") ? NET_TLS_PSK_AND_ECC_CIPHER :
+                        NET_TLS_PSK_CIPHER;
+    config.psk_key_id = MBED_CONF_APP_PSK_KEY_ID;
+    config.tls_psk_key_id = MBED_CONF_APP_TLS_PSK_KEY_ID;
+
+    return config;
+}
+
+constexpr br_config_t config_value = make_config();
+
+} // namespace
+
+const br_config_t br_config = config_value;
+
+#endif // MBED_CONF_APP_MESH_MODE
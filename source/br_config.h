@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#ifndef BR_CONFIG_H
+#define BR_CONFIG_H
+
+#include "ns_types.h"
+#include "net_interface.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct br_route_config {
+    uint8_t prefix[16];
+    uint8_t prefix_len;
+} br_route_config_t;
+
+/**
+ * 6LoWPAN ND border router configuration.
+ *
+ * Built from the MBED_CONF_APP_* values at compile time, so addresses are
+ * already parsed and an invalid value fails the build.
+ */
+typedef struct br_config {
+    /* RF */
+    uint8_t prefix[16];
+    uint8_t network_id[16];
+    uint16_t pan_id;
+    uint16_t short_mac_address;
+    uint8_t rf_channel;
+    uint8_t rf_channel_page;
+    uint32_t rf_channel_mask;
+    uint16_t ra_router_lifetime;
+    uint8_t beacon_protocol_id;
+    uint8_t multicast_addr[16];
+    bool prefix_from_backhaul;
+    bool mesh_before_backhaul;
+
+    /* RPL */
+    uint8_t rpl_instance_id;
+    uint8_t rpl_idoublings;
+    uint8_t rpl_imin;
+    uint8_t rpl_k;
+    uint16_t rpl_max_rank_inc;
+    uint16_t rpl_min_hop_rank_inc;
+    uint16_t rpl_default_lifetime;
+    uint16_t rpl_lifetime_unit;
+    uint8_t rpl_pcs;
+    uint8_t rpl_ocp;
+
+    /* Backhaul */
+    uint8_t backhaul_prefix[16];
+    br_route_config_t backhaul_default_route;
+    uint8_t backhaul_next_hop[16];
+    bool backhaul_dynamic_bootstrap;
+
+    /* Security */
+    net_6lowpan_link_layer_sec_mode_e security_mode;
+    net_tls_cipher_e pana_suite;
+    uint8_t psk_key_id;
+    uint8_t psk_key[16];
+    uint16_t tls_psk_key_id;
+    uint8_t tls_psk_key[16];
+} br_config_t;
+
+extern const br_config_t br_config;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BR_CONFIG_H */
@@ -0,0 +1,405 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#define LOWPAN_ND 0
+#define THREAD 1
+#define LOWPAN_WS 2
+#if MBED_CONF_APP_MESH_MODE == LOWPAN_ND
+
+#include <string.h>
+#include <stdio.h>
+#include "ns_types.h"
+#include "common_functions.h"
+#include "socket_api.h"
+#include "br_config_store.h"
+#include "borderrouter_helpers.h"
+
+#include "ns_trace.h"
+#define TRACE_GROUP "cfgs"
+
+/* Must be defined for next preprocessor tests to work */
+#define NONE 0
+#define KVSTORE 1
+#define FILE_STORE 2
+
+#ifndef MBED_CONF_APP_CONFIG_STORE
+#define MBED_CONF_APP_CONFIG_STORE NONE
+#endif
+
+#ifndef MBED_CONF_APP_CONFIG_STORE_PATH
+#define MBED_CONF_APP_CONFIG_STORE_PATH "/fs/nsbr-config.bin"
+#endif
+
+#ifndef MBED_CONF_APP_CONFIG_PORT
+#define MBED_CONF_APP_CONFIG_PORT 0
+#endif
+
+#if MBED_CONF_APP_CONFIG_STORE == KVSTORE
+#include "kvstore_global_api.h"
+#define CONFIG_STORE_KEY "/kv/br_config"
+#endif
+
+#if MBED_CONF_APP_CONFIG_PORT
+#include "kvstore_global_api.h"
+#include "mbedtls/md.h"
+#define CONFIG_PORT_COUNTER "/kv/br_config_counter"
+#define CONFIG_PORT_KEY_MIN_LEN 16
+#define CONFIG_PORT_KEY_MAX_LEN 64
+#endif
+
+#define RECORD_VERSION 1
+
+/* RPL limits, the largest DIO interval must fit 2^31 ms */
+#define RPL_IMIN_MIN 1
+#define RPL_INTERVAL_EXP_MAX 31
+
+static br_config_apply_cb *apply;
+static br_config_t active;
+static uint8_t stored[BR_CONFIG_RECORD_LEN];
+static bool stored_valid;
+static int8_t config_interface_id = -1;
+#if MBED_CONF_APP_CONFIG_PORT
+static int8_t config_socket = -1;
+static uint8_t config_key[CONFIG_PORT_KEY_MAX_LEN];
+static size_t config_key_len;
+static uint32_t config_counter;
+#endif
+
+static uint16_t crc16_ccitt(const uint8_t *data, uint16_t len)
+{
+    uint16_t crc = 0xffff;
+
+    while (len--) {
+        crc ^= (uint16_t) *data++ << 8;
+        for (uint8_t i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+/* RPL DODAG configuration limits of RFC 6550 section 6.7.6 and the stack */
+static bool record_rpl_valid(const uint8_t *record)
+{
+    uint8_t imin = record[9];
+    uint8_t idoublings = record[10];
+    uint16_t min_hop_rank_inc = common_read_16_bit(&record[14]);
+    uint16_t default_lifetime = common_read_16_bit(&record[16]);
+    uint16_t lifetime_unit = common_read_16_bit(&record[18]);
+
+    if (imin < RPL_IMIN_MIN || imin + idoublings > RPL_INTERVAL_EXP_MAX) {
+        return false;
+    }
+    /* Ranks can not increase with a zero MinHopRankIncrease */
+    if (min_hop_rank_inc == 0) {
+        return false;
+    }
+    /* Goes to the 8-bit Default Lifetime of the DODAG configuration option */
+    if (lifetime_unit == 0 || lifetime_unit > 0xff || default_lifetime == 0) {
+        return false;
+    }
+    return true;
+}
+
+static bool record_valid(const uint8_t *record, uint16_t len)
+{
+    uint8_t fields;
+
+    if (len != BR_CONFIG_RECORD_LEN || memcmp(record, "BRCF", 4) != 0 || record[4] != RECORD_VERSION ||
+            common_read_16_bit(&record[53]) != crc16_ccitt(record, 53)) {
+        return false;
+    }
+
+    fields = record[5];
+    if ((fields & BR_CONFIG_FIELD_PAN_ID) && common_read_16_bit(&record[6]) == 0xffff) {
+        return false;
+    }
+    if ((fields & BR_CONFIG_FIELD_RF_CHANNEL) && active.rf_channel_page == 0 && record[8] > 26) {
+        return false;
+    }
+    if ((fields & BR_CONFIG_FIELD_RPL) && !record_rpl_valid(record)) {
+        return false;
+    }
+    if ((fields & BR_CONFIG_FIELD_BACKHAUL_ROUTE) && record[20] > 128) {
+        return false;
+    }
+    return true;
+}
+
+/* Applies the fields of a valid record to a configuration, returns the changed subsystems */
+static uint8_t record_merge(br_config_t *config, const uint8_t *record)
+{
+    br_config_t old = *config;
+    uint8_t fields = record[5];
+    uint8_t changed = 0;
+
+    if (fields & BR_CONFIG_FIELD_PAN_ID) {
+        config->pan_id = common_read_16_bit(&record[6]);
+    }
+    if (fields & BR_CONFIG_FIELD_RF_CHANNEL) {
+        config->rf_channel = record[8];
+    }
+    if (fields & BR_CONFIG_FIELD_RPL) {
+        config->rpl_imin = record[9];
+        config->rpl_idoublings = record[10];
+        config->rpl_k = record[11];
+        config->rpl_max_rank_inc = common_read_16_bit(&record[12]);
+        config->rpl_min_hop_rank_inc = common_read_16_bit(&record[14]);
+        config->rpl_default_lifetime = common_read_16_bit(&record[16]);
+        config->rpl_lifetime_unit = common_read_16_bit(&record[18]);
+    }
+    if (fields & BR_CONFIG_FIELD_BACKHAUL_ROUTE) {
+        config->backhaul_default_route.prefix_len = record[20];
+        memcpy(config->backhaul_default_route.prefix, &record[21], 16);
+        memcpy(config->backhaul_next_hop, &record[37], 16);
+    }
+
+    if (old.pan_id != config->pan_id || old.rf_channel != config->rf_channel) {
+        changed |= BR_CONFIG_CHANGED_RF;
+    }
+    if (old.rpl_imin != config->rpl_imin || old.rpl_idoublings != config->rpl_idoublings ||
+            old.rpl_k != config->rpl_k || old.rpl_max_rank_inc != config->rpl_max_rank_inc ||
+            old.rpl_min_hop_rank_inc != config->rpl_min_hop_rank_inc ||
+            old.rpl_default_lifetime != config->rpl_default_lifetime ||
+            old.rpl_lifetime_unit != config->rpl_lifetime_unit) {
+        changed |= BR_CONFIG_CHANGED_DODAG;
+    }
+    if (memcmp(&old.backhaul_default_route, &config->backhaul_default_route, sizeof(old.backhaul_default_route)) ||
+            memcmp(old.backhaul_next_hop, config->backhaul_next_hop, 16)) {
+        changed |= BR_CONFIG_CHANGED_BACKHAUL;
+    }
+    return changed;
+}
+
+/* Combines a new record into the stored one, fields of the new record win */
+static void record_combine(uint8_t *dst, const uint8_t *src)
+{
+    uint8_t fields = src[5];
+
+    if (!stored_valid) {
+        memcpy(dst, src, BR_CONFIG_RECORD_LEN);
+        return;
+    }
+    if (fields & BR_CONFIG_FIELD_PAN_ID) {
+        memcpy(&dst[6], &src[6], 2);
+    }
+    if (fields & BR_CONFIG_FIELD_RF_CHANNEL) {
+        dst[8] = src[8];
+    }
+    if (fields & BR_CONFIG_FIELD_RPL) {
+        memcpy(&dst[9], &src[9], 11);
+    }
+    if (fields & BR_CONFIG_FIELD_BACKHAUL_ROUTE) {
+        memcpy(&dst[20], &src[20], 33);
+    }
+    dst[5] |= fields;
+    common_write_16_bit(crc16_ccitt(dst, 53), &dst[53]);
+}
+
+static int store_read(uint8_t *record)
+{
+#if MBED_CONF_APP_CONFIG_STORE == KVSTORE
+    size_t actual = 0;
+    if (kv_get(CONFIG_STORE_KEY, record, BR_CONFIG_RECORD_LEN, &actual) != 0 || actual != BR_CONFIG_RECORD_LEN) {
+        return -1;
+    }
+    return 0;
+#elif MBED_CONF_APP_CONFIG_STORE == FILE_STORE
+    FILE *f = fopen(MBED_CONF_APP_CONFIG_STORE_PATH, "rb");
+    size_t actual;
+    if (!f) {
+        return -1;
+    }
+    actual = fread(record, 1, BR_CONFIG_RECORD_LEN, f);
+    fclose(f);
+    return actual == BR_CONFIG_RECORD_LEN ? 0 : -1;
+#else
+    (void) record;
+    return -1;
+#endif
+}
+
+static int store_write(const uint8_t *record)
+{
+#if MBED_CONF_APP_CONFIG_STORE == KVSTORE
+    return kv_set(CONFIG_STORE_KEY, record, BR_CONFIG_RECORD_LEN, 0) == 0 ? 0 : -1;
+#elif MBED_CONF_APP_CONFIG_STORE == FILE_STORE
+    FILE *f = fopen(MBED_CONF_APP_CONFIG_STORE_PATH, "wb");
+    size_t written;
+    if (!f) {
+        return -1;
+    }
+    written = fwrite(record, 1, BR_CONFIG_RECORD_LEN, f);
+    if (fclose(f) != 0) {
+        return -1;
+    }
+    return written == BR_CONFIG_RECORD_LEN ? 0 : -1;
+#else
+    (void) record;
+    return -1;
+#endif
+}
+
+void br_config_store_load(br_config_t *config)
+{
+    active = br_config;
+
+    if (store_read(stored) == 0 && record_valid(stored, BR_CONFIG_RECORD_LEN)) {
+        stored_valid = true;
+        record_merge(&active, stored);
+        tr_info("Stored configuration overlay applied, fields 0x%02x", stored[5]);
+    }
+    *config = active;
+}
+
+void br_config_store_start(br_config_apply_cb *apply_cb)
+{
+    apply = apply_cb;
+}
+
+int br_config_store_update(const uint8_t *record, uint16_t len)
+{
+    uint8_t combined[BR_CONFIG_RECORD_LEN];
+    br_config_t config = active;
+    uint8_t changed;
+    int retval = 0;
+
+    if (!record_valid(record, len)) {
+        tr_warn("Invalid configuration record");
+        return -1;
+    }
+
+    changed = record_merge(&config, record);
+    tr_info("Configuration update, subsystems 0x%02x", changed);
+    if (changed && apply && !apply(&config, changed)) {
+        tr_warn("Configuration refused, not stored");
+        return -1;
+    }
+    active = config;
+
+    memcpy(combined, stored, sizeof(combined));
+    record_combine(combined, record);
+    if (store_write(combined) == 0) {
+        memcpy(stored, combined, sizeof(stored));
+        stored_valid = true;
+    } else {
+        tr_warn("Configuration not stored, applied until reboot");
+        retval = -2;
+    }
+    return retval;
+}
+
+int br_config_store_clear(void)
+{
+    stored_valid = false;
+    memset(stored, 0, sizeof(stored));
+#if MBED_CONF_APP_CONFIG_STORE == KVSTORE
+    return kv_remove(CONFIG_STORE_KEY) == 0 ? 0 : -1;
+#elif MBED_CONF_APP_CONFIG_STORE == FILE_STORE
+    return remove(MBED_CONF_APP_CONFIG_STORE_PATH) == 0 ? 0 : -1;
+#else
+    return 0;
+#endif
+}
+
+#if MBED_CONF_APP_CONFIG_PORT
+static bool frame_authentic(const uint8_t *frame)
+{
+    uint8_t mac[BR_CONFIG_MAC_LEN];
+    uint8_t diff = 0;
+
+    if (mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), config_key, config_key_len,
+                        frame, BR_CONFIG_RECORD_LEN + 4, mac) != 0) {
+        return false;
+    }
+    /* Constant time, a mismatch position must not leak through timing */
+    for (uint8_t i = 0; i < BR_CONFIG_MAC_LEN; i++) {
+        diff |= mac[i] ^ frame[BR_CONFIG_RECORD_LEN + 4 + i];
+    }
+    return diff == 0;
+}
+
+static void config_socket_cb(void *cb)
+{
+    socket_callback_t *sock_cb = (socket_callback_t *) cb;
+    uint8_t frame[BR_CONFIG_FRAME_LEN + 1];
+    uint8_t counter_buf[4];
+    ns_address_t src;
+    uint32_t counter;
+    int16_t len;
+    int8_t status;
+
+    if ((sock_cb->event_type & SOCKET_EVENT_MASK) != SOCKET_DATA) {
+        return;
+    }
+
+    len = socket_recvfrom(sock_cb->socket_id, frame, sizeof(frame), 0, &src);
+    if (len < 0 || sock_cb->interface_id != config_interface_id) {
+        return;
+    }
+
+    /* Unauthenticated frames are dropped without an answer */
+    if (len != BR_CONFIG_FRAME_LEN || !frame_authentic(frame)) {
+        tr_warn("Unauthenticated configuration frame from %s dropped", tr_ipv6(src.address));
+        return;
+    }
+    counter = common_read_32_bit(&frame[BR_CONFIG_RECORD_LEN]);
+    if (counter <= config_counter) {
+        tr_warn("Replayed configuration frame, counter %lu dropped", (unsigned long) counter);
+        return;
+    }
+
+    /* Counter is stored first, a frame is never accepted twice */
+    common_write_32_bit(counter, counter_buf);
+    if (kv_set(CONFIG_PORT_COUNTER, counter_buf, sizeof(counter_buf), 0) != 0) {
+        tr_error("Configuration counter not stored, frame dropped");
+        return;
+    }
+    config_counter = counter;
+
+    status = br_config_store_update(frame, BR_CONFIG_RECORD_LEN);
+    socket_sendto(sock_cb->socket_id, &src, &status, sizeof(status));
+}
+
+static bool config_port_key_load(void)
+{
+    uint8_t counter_buf[4];
+    size_t actual = 0;
+
+    if (kv_get(BR_CONFIG_PORT_KEY, config_key, sizeof(config_key), &config_key_len) != 0 ||
+            config_key_len < CONFIG_PORT_KEY_MIN_LEN) {
+        return false;
+    }
+    if (kv_get(CONFIG_PORT_COUNTER, counter_buf, sizeof(counter_buf), &actual) == 0 && actual == sizeof(counter_buf)) {
+        config_counter = common_read_32_bit(counter_buf);
+    }
+    return true;
+}
+#endif
+
+void br_config_store_port_open(int8_t interface_id)
+{
+    config_interface_id = interface_id;
+
+#if MBED_CONF_APP_CONFIG_PORT
+    if (config_socket >= 0) {
+        return;
+    }
+
+    if (!config_port_key_load()) {
+        tr_error("Configuration port needs a key of %d-%d bytes in %s, not opened",
+                 CONFIG_PORT_KEY_MIN_LEN, CONFIG_PORT_KEY_MAX_LEN, BR_CONFIG_PORT_KEY);
+        return;
+    }
+
+    config_socket = socket_open(SOCKET_UDP, MBED_CONF_APP_CONFIG_PORT, config_socket_cb);
+    if (config_socket < 0) {
+        tr_error("Configuration port %d open failed", MBED_CONF_APP_CONFIG_PORT);
+        return;
+    }
+    tr_info("Configuration port %d, counter %lu", MBED_CONF_APP_CONFIG_PORT, (unsigned long) config_counter);
+#endif
+}
+
+#endif // MBED_CONF_APP_MESH_MODE
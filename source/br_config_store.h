@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#ifndef BR_CONFIG_STORE_H
+#define BR_CONFIG_STORE_H
+
+#include "ns_types.h"
+#include "br_config.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+ * Overlay record, big-endian:
+ *
+ *  0  magic "BRCF"         4
+ *  4  version (1)          1
+ *  5  fields               1   BR_CONFIG_FIELD_* mask of the values that apply
+ *  6  pan_id               2
+ *  8  rf_channel           1
+ *  9  rpl_imin             1
+ * 10  rpl_idoublings       1
+ * 11  rpl_k                1
+ * 12  rpl_max_rank_inc     2
+ * 14  rpl_min_hop_rank_inc 2
+ * 16  rpl_default_lifetime 2
+ * 18  rpl_lifetime_unit    2
+ * 20  route prefix_len     1
+ * 21  route prefix        16
+ * 37  route next hop      16
+ * 53  CRC-16/CCITT         2   over bytes 0-52
+ */
+#define BR_CONFIG_RECORD_LEN 55
+
+/*
+ * Frame accepted on "config-port", big-endian:
+ *
+ *  0  record              55
+ * 55  counter              4   greater than the counter of any earlier frame
+ * 59  HMAC-SHA256         32   over bytes 0-58, keyed with BR_CONFIG_PORT_KEY
+ */
+#define BR_CONFIG_MAC_LEN 32
+#define BR_CONFIG_FRAME_LEN (BR_CONFIG_RECORD_LEN + 4 + BR_CONFIG_MAC_LEN)
+
+/* KVStore key holding the 16-64 byte HMAC key of "config-port" */
+#define BR_CONFIG_PORT_KEY "/kv/br_config_key"
+
+#define BR_CONFIG_FIELD_PAN_ID          0x01
+#define BR_CONFIG_FIELD_RF_CHANNEL      0x02
+#define BR_CONFIG_FIELD_RPL             0x04
+#define BR_CONFIG_FIELD_BACKHAUL_ROUTE  0x08
+
+/* Subsystems touched by a change */
+#define BR_CONFIG_CHANGED_RF            0x01
+#define BR_CONFIG_CHANGED_DODAG         0x02
+#define BR_CONFIG_CHANGED_BACKHAUL      0x04
+
+/**
+ * Applies a new configuration. Only the subsystems in the changed mask
+ * need to be reconfigured.
+ *
+ * \return false if the configuration is refused, it is then not stored
+ */
+typedef bool br_config_apply_cb(const br_config_t *config, uint8_t changed);
+
+/**
+ * Loads the compiled defaults with the stored overlay on top.
+ */
+void br_config_store_load(br_config_t *config);
+
+/**
+ * Registers the apply callback.
+ */
+void br_config_store_start(br_config_apply_cb *apply_cb);
+
+/**
+ * Opens the "config-port" UDP port, accepting authenticated frames from the
+ * given interface only. Does nothing if the port is 0, or if there is no key
+ * in BR_CONFIG_PORT_KEY.
+ */
+void br_config_store_port_open(int8_t interface_id);
+
+/**
+ * Validates a record, applies the result and merges it into the stored
+ * overlay.
+ *
+ * \return 0 on success, -1 on an invalid or refused record, -2 if it could not be stored
+ */
+int br_config_store_update(const uint8_t *record, uint16_t len);
+
+/**
+ * Removes the stored overlay. Takes effect on the next boot.
+ */
+int br_config_store_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BR_CONFIG_STORE_H */
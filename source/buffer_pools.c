@@ -0,0 +1,411 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#include <string.h>
+#include "ns_types.h"
+#include "nsdynmemLIB.h"
+#include "eventOS_event.h"
+#include "eventOS_event_timer.h"
+#include "randLIB.h"
+#include "platform/arm_hal_interrupt.h"
+#include "buffer_pools.h"
+
+#include "ns_trace.h"
+#define TRACE_GROUP "pool"
+
+#ifndef MBED_CONF_APP_BUFFER_POOLS
+#define MBED_CONF_APP_BUFFER_POOLS 0
+#endif
+
+#ifndef MBED_CONF_APP_BUFFER_POOL_1_SIZE
+#define MBED_CONF_APP_BUFFER_POOL_1_SIZE 64
+#endif
+
+#ifndef MBED_CONF_APP_BUFFER_POOL_1_COUNT
+#define MBED_CONF_APP_BUFFER_POOL_1_COUNT 16
+#endif
+
+#ifndef MBED_CONF_APP_BUFFER_POOL_2_SIZE
+#define MBED_CONF_APP_BUFFER_POOL_2_SIZE 320
+#endif
+
+#ifndef MBED_CONF_APP_BUFFER_POOL_2_COUNT
+#define MBED_CONF_APP_BUFFER_POOL_2_COUNT 16
+#endif
+
+#ifndef MBED_CONF_APP_BUFFER_POOL_3_SIZE
+#define MBED_CONF_APP_BUFFER_POOL_3_SIZE 640
+#endif
+
+#ifndef MBED_CONF_APP_BUFFER_POOL_3_COUNT
+#define MBED_CONF_APP_BUFFER_POOL_3_COUNT 4
+#endif
+
+#ifndef MBED_CONF_APP_BUFFER_POOL_4_SIZE
+#define MBED_CONF_APP_BUFFER_POOL_4_SIZE 1536
+#endif
+
+#ifndef MBED_CONF_APP_BUFFER_POOL_4_COUNT
+#define MBED_CONF_APP_BUFFER_POOL_4_COUNT 2
+#endif
+
+#ifndef MBED_CONF_APP_BUFFER_POOLS_BENCH_ALLOCS
+#define MBED_CONF_APP_BUFFER_POOLS_BENCH_ALLOCS 0
+#endif
+
+#ifndef MBED_CONF_APP_BUFFER_POOLS_BENCH_MS
+#define MBED_CONF_APP_BUFFER_POOLS_BENCH_MS 100
+#endif
+
+/* The pools are linked in with the --wrap option of the GNU linker, which ARM and IAR do not have */
+#if MBED_CONF_APP_BUFFER_POOLS && (!defined(__GNUC__) || defined(__ARMCC_VERSION) || defined(__CC_ARM))
+#error "buffer-pools is supported with the GCC_ARM toolchain only"
+#endif
+
+/* The build profile wraps the ns_dyn_mem calls at link time and defines BUFFER_POOLS_WRAP */
+#if MBED_CONF_APP_BUFFER_POOLS && !defined(BUFFER_POOLS_WRAP)
+#error "buffer-pools needs the profiles/buffer_pools.json build profile"
+#endif
+
+/* Blocks keep the alignment ns_dyn_mem gives, and hold at least the free list link */
+#define BLOCK_ALIGN(size) (((size) + 7) & ~7)
+#define BLOCK_SIZE(size) BLOCK_ALIGN((size) < 8 ? 8 : (size))
+#define POOL_BYTES(size, count) ((size) ? BLOCK_SIZE(size) * (count) : 0)
+
+/* The pools have their own region, so the heap statistics count only the heap */
+#define POOL_REGION_BYTES \
+    (POOL_BYTES(MBED_CONF_APP_BUFFER_POOL_1_SIZE, MBED_CONF_APP_BUFFER_POOL_1_COUNT) + \
+     POOL_BYTES(MBED_CONF_APP_BUFFER_POOL_2_SIZE, MBED_CONF_APP_BUFFER_POOL_2_COUNT) + \
+     POOL_BYTES(MBED_CONF_APP_BUFFER_POOL_3_SIZE, MBED_CONF_APP_BUFFER_POOL_3_COUNT) + \
+     POOL_BYTES(MBED_CONF_APP_BUFFER_POOL_4_SIZE, MBED_CONF_APP_BUFFER_POOL_4_COUNT))
+
+#if MBED_CONF_APP_BUFFER_POOLS && POOL_REGION_BYTES == 0
+#error "buffer-pools needs at least one pool with a size and a count"
+#endif
+
+#define BENCH_TIMER 1
+#define BENCH_SLOTS 64
+#define BENCH_REPORT_MS 60000
+#define BENCH_REPORT_TICKS (BENCH_REPORT_MS > MBED_CONF_APP_BUFFER_POOLS_BENCH_MS ? \
+                            BENCH_REPORT_MS / MBED_CONF_APP_BUFFER_POOLS_BENCH_MS : 1)
+
+#if MBED_CONF_APP_BUFFER_POOLS
+/* A free block holds the link to the next free block */
+typedef struct pool_block {
+    struct pool_block *next;
+} pool_block_t;
+
+typedef struct buffer_pool {
+    uint8_t *start;
+    uint8_t *end;
+    pool_block_t *free_list;
+    buffer_pool_stats_t stats;
+} buffer_pool_t;
+
+static const uint16_t pool_config[BUFFER_POOL_MAX][2] = {
+    {MBED_CONF_APP_BUFFER_POOL_1_SIZE, MBED_CONF_APP_BUFFER_POOL_1_COUNT},
+    {MBED_CONF_APP_BUFFER_POOL_2_SIZE, MBED_CONF_APP_BUFFER_POOL_2_COUNT},
+    {MBED_CONF_APP_BUFFER_POOL_3_SIZE, MBED_CONF_APP_BUFFER_POOL_3_COUNT},
+    {MBED_CONF_APP_BUFFER_POOL_4_SIZE, MBED_CONF_APP_BUFFER_POOL_4_COUNT},
+};
+
+/* Pools in use, smallest block first */
+static buffer_pool_t pools[BUFFER_POOL_MAX];
+static uint8_t pool_count;
+static uint32_t oversize;
+static uint64_t pool_region[POOL_REGION_BYTES / sizeof(uint64_t)];
+static uint32_t pool_region_used;
+
+void *__real_ns_dyn_mem_temporary_alloc(ns_mem_block_size_t alloc_size);
+void __real_ns_dyn_mem_free(void *heap_ptr);
+
+static void pool_create(uint16_t size, uint16_t count)
+{
+    uint16_t block_size = BLOCK_SIZE(size);
+    uint8_t *start = (uint8_t *)pool_region + pool_region_used;
+    uint8_t i;
+
+    pool_region_used += (uint32_t)block_size * count;
+
+    /* Keep the pools sorted so that an allocation takes the smallest block it fits */
+    for (i = pool_count; i > 0 && pools[i - 1].stats.block_size > block_size; i--) {
+        pools[i] = pools[i - 1];
+    }
+
+    buffer_pool_t *pool = &pools[i];
+    memset(pool, 0, sizeof(buffer_pool_t));
+    pool->start = start;
+    pool->end = start + (uint32_t)block_size * count;
+    pool->stats.block_size = block_size;
+    pool->stats.blocks = count;
+    for (uint16_t n = count; n > 0; n--) {
+        pool_block_t *block = (pool_block_t *)(start + (uint32_t)block_size * (n - 1));
+        block->next = pool->free_list;
+        pool->free_list = block;
+    }
+    pool_count++;
+}
+
+static void *pool_alloc(ns_mem_block_size_t alloc_size)
+{
+    if (alloc_size == 0) {
+        return NULL;
+    }
+
+    for (uint8_t i = 0; i < pool_count; i++) {
+        buffer_pool_t *pool = &pools[i];
+        pool_block_t *block;
+
+        if ((uint32_t)alloc_size > pool->stats.block_size) {
+            continue;
+        }
+
+        /* Only the smallest fitting pool, larger blocks stay for larger buffers */
+        platform_enter_critical();
+        block = pool->free_list;
+        if (block) {
+            pool->free_list = block->next;
+            pool->stats.allocs++;
+            if (++pool->stats.in_use > pool->stats.in_use_max) {
+                pool->stats.in_use_max = pool->stats.in_use;
+            }
+        } else {
+            pool->stats.fallbacks++;
+        }
+        platform_exit_critical();
+        return block;
+    }
+
+    if (pool_count) {
+        platform_enter_critical();
+        oversize++;
+        platform_exit_critical();
+    }
+    return NULL;
+}
+
+static bool pool_free(void *ptr)
+{
+    for (uint8_t i = 0; i < pool_count; i++) {
+        buffer_pool_t *pool = &pools[i];
+
+        if ((uint8_t *)ptr < pool->start || (uint8_t *)ptr >= pool->end) {
+            continue;
+        }
+
+        pool_block_t *block = ptr;
+        platform_enter_critical();
+        block->next = pool->free_list;
+        pool->free_list = block;
+        pool->stats.in_use--;
+        platform_exit_critical();
+        return true;
+    }
+    return false;
+}
+
+/* Linked in place of the ns_dyn_mem functions by --wrap */
+void *__wrap_ns_dyn_mem_temporary_alloc(ns_mem_block_size_t alloc_size)
+{
+    void *block = pool_alloc(alloc_size);
+
+    return block ? block : __real_ns_dyn_mem_temporary_alloc(alloc_size);
+}
+
+void __wrap_ns_dyn_mem_free(void *heap_ptr)
+{
+    if (!pool_free(heap_ptr)) {
+        __real_ns_dyn_mem_free(heap_ptr);
+    }
+}
+#elif defined(BUFFER_POOLS_WRAP)
+void *__real_ns_dyn_mem_temporary_alloc(ns_mem_block_size_t alloc_size);
+void __real_ns_dyn_mem_free(void *heap_ptr);
+
+/* The build profile wraps the ns_dyn_mem calls also when the pools are off */
+void *__wrap_ns_dyn_mem_temporary_alloc(ns_mem_block_size_t alloc_size)
+{
+    return __real_ns_dyn_mem_temporary_alloc(alloc_size);
+}
+
+void __wrap_ns_dyn_mem_free(void *heap_ptr)
+{
+    __real_ns_dyn_mem_free(heap_ptr);
+}
+#endif /* MBED_CONF_APP_BUFFER_POOLS */
+
+#if MBED_CONF_APP_BUFFER_POOLS_BENCH_ALLOCS
+typedef struct bench_slot {
+    void *ptr;
+    uint16_t ticks_left;
+} bench_slot_t;
+
+static bench_slot_t bench_slots[BENCH_SLOTS];
+static uint32_t bench_allocs;
+static uint32_t bench_fails;
+static uint32_t bench_fragmented;
+static uint32_t bench_ticks;
+
+/*
+ * One allocation of the stack mix: mostly short-lived small messages and
+ * frame buffers, some full IPv6 packets, and now and then a long-lived entry
+ * such as a neighbour or a route.
+ */
+static void bench_alloc(bench_slot_t *slot)
+{
+    const mem_stat_t *heap_info = ns_dyn_mem_get_mem_stat();
+    uint32_t heap_free = 0;
+    uint16_t size;
+    uint8_t mix = randLIB_get_random_in_range(0, 99);
+
+    if (heap_info) {
+        heap_free = heap_info->heap_sector_size - heap_info->heap_sector_allocated_bytes;
+    }
+
+    if (mix < 6) {
+        size = randLIB_get_random_in_range(24, 200);
+        slot->ticks_left = randLIB_get_random_in_range(100, 1000);
+        slot->ptr = ns_dyn_mem_alloc(size);
+    } else {
+        if (mix < 60) {
+            size = randLIB_get_random_in_range(16, 96);
+        } else if (mix < 90) {
+            size = randLIB_get_random_in_range(160, 320);
+        } else {
+            size = randLIB_get_random_in_range(1000, 1400);
+        }
+        slot->ticks_left = randLIB_get_random_in_range(1, 50);
+        slot->ptr = ns_dyn_mem_temporary_alloc(size);
+    }
+
+    bench_allocs++;
+    if (!slot->ptr) {
+        bench_fails++;
+        /* Enough bytes free but no block large enough: fragmentation */
+        if (heap_free >= size) {
+            bench_fragmented++;
+        }
+        return;
+    }
+    memset(slot->ptr, 0xa5, size);
+}
+
+static void bench_report(void)
+{
+    const mem_stat_t *heap_info = ns_dyn_mem_get_mem_stat();
+
+    tr_info("Bench: %lu allocs, %lu failed, %lu of them with enough free heap",
+            (unsigned long)bench_allocs, (unsigned long)bench_fails, (unsigned long)bench_fragmented);
+    if (heap_info) {
+        tr_info("Bench: heap %lu of %lu bytes in use, %lu alloc fails",
+                (unsigned long)heap_info->heap_sector_allocated_bytes,
+                (unsigned long)heap_info->heap_sector_size,
+                (unsigned long)heap_info->heap_alloc_fail_cnt);
+    }
+    buffer_pools_print();
+}
+
+static void bench_tasklet(arm_event_s *event)
+{
+    uint16_t allocs = MBED_CONF_APP_BUFFER_POOLS_BENCH_ALLOCS;
+
+    switch (event->event_type) {
+        case ARM_LIB_TASKLET_INIT_EVENT:
+            break;
+
+        case ARM_LIB_SYSTEM_TIMER_EVENT:
+            if (event->event_id != BENCH_TIMER) {
+                return;
+            }
+            for (uint8_t i = 0; i < BENCH_SLOTS; i++) {
+                bench_slot_t *slot = &bench_slots[i];
+                if (slot->ptr && --slot->ticks_left == 0) {
+                    ns_dyn_mem_free(slot->ptr);
+                    slot->ptr = NULL;
+                }
+            }
+            for (uint8_t i = 0; i < BENCH_SLOTS && allocs; i++) {
+                if (!bench_slots[i].ptr) {
+                    bench_alloc(&bench_slots[i]);
+                    allocs--;
+                }
+            }
+            if (++bench_ticks % BENCH_REPORT_TICKS == 0) {
+                bench_report();
+            }
+            break;
+
+        default:
+            return;
+    }
+    eventOS_event_timer_request(BENCH_TIMER, ARM_LIB_SYSTEM_TIMER_EVENT, event->receiver,
+                                MBED_CONF_APP_BUFFER_POOLS_BENCH_MS);
+}
+#endif /* MBED_CONF_APP_BUFFER_POOLS_BENCH_ALLOCS */
+
+void buffer_pools_init(void)
+{
+#if MBED_CONF_APP_BUFFER_POOLS
+    if (pool_count) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < BUFFER_POOL_MAX; i++) {
+        if (pool_config[i][0] && pool_config[i][1]) {
+            pool_create(pool_config[i][0], pool_config[i][1]);
+        }
+    }
+    for (uint8_t i = 0; i < pool_count; i++) {
+        tr_info("Pool %u: %u blocks of %u bytes", i + 1, pools[i].stats.blocks, pools[i].stats.block_size);
+    }
+    tr_info("Pools: %lu bytes outside the nanostack heap", (unsigned long)pool_region_used);
+#endif
+
+#if MBED_CONF_APP_BUFFER_POOLS_BENCH_ALLOCS
+    tr_warn("Heap benchmark: %u allocations every %u ms", MBED_CONF_APP_BUFFER_POOLS_BENCH_ALLOCS,
+            MBED_CONF_APP_BUFFER_POOLS_BENCH_MS);
+    eventOS_event_handler_create(&bench_tasklet, ARM_LIB_TASKLET_INIT_EVENT);
+#endif
+}
+
+const buffer_pool_stats_t *buffer_pools_stats_get(uint8_t pool)
+{
+#if MBED_CONF_APP_BUFFER_POOLS
+    if (pool < pool_count) {
+        return &pools[pool].stats;
+    }
+#else
+    (void)pool;
+#endif
+    return NULL;
+}
+
+uint32_t buffer_pools_bytes_in_use(void)
+{
+    uint32_t bytes = 0;
+
+#if MBED_CONF_APP_BUFFER_POOLS
+    for (uint8_t i = 0; i < pool_count; i++) {
+        bytes += (uint32_t)pools[i].stats.in_use * pools[i].stats.block_size;
+    }
+#endif
+    return bytes;
+}
+
+void buffer_pools_print(void)
+{
+#if MBED_CONF_APP_BUFFER_POOLS
+    for (uint8_t i = 0; i < pool_count; i++) {
+        const buffer_pool_stats_t *stats = &pools[i].stats;
+        tr_info("Pool %u: %u bytes, %u of %u in use, max %u, allocs %lu, fallbacks %lu",
+                i + 1, stats->block_size, stats->in_use, stats->blocks, stats->in_use_max,
+                (unsigned long)stats->allocs, (unsigned long)stats->fallbacks);
+    }
+    if (pool_count) {
+        tr_info("Pools: %lu of %lu bytes in use, %lu allocations too large for a pool",
+                (unsigned long)buffer_pools_bytes_in_use(), (unsigned long)pool_region_used,
+                (unsigned long)oversize);
+    }
+#endif
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#ifndef BUFFER_POOLS_H
+#define BUFFER_POOLS_H
+
+#include "ns_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define BUFFER_POOL_MAX 4
+
+typedef struct buffer_pool_stats {
+    uint16_t block_size;            /**< Bytes of a block, 0 if the pool is not in use */
+    uint16_t blocks;                /**< Blocks in the pool */
+    uint16_t in_use;                /**< Blocks allocated now */
+    uint16_t in_use_max;            /**< High-water mark of in_use */
+    uint32_t allocs;                /**< Allocations served by the pool */
+    uint32_t fallbacks;             /**< Allocations for the pool passed to ns_dyn_mem, pool empty */
+} buffer_pool_stats_t;
+
+/**
+ * Sets up the pools in their own static region, outside the nanostack heap,
+ * so that the heap statistics do not include them. Call once before the
+ * stack starts. From then on a temporary nanostack
+ * allocation is served by the smallest pool it fits, and by ns_dyn_mem when
+ * that pool is empty or the allocation fits no pool. Does nothing unless
+ * "buffer-pools" is set.
+ *
+ * Also starts the fragmentation benchmark if "buffer-pools-bench-allocs" is set.
+ */
+void buffer_pools_init(void);
+
+/**
+ * Returns the counters of a pool, NULL if there is no such pool.
+ */
+const buffer_pool_stats_t *buffer_pools_stats_get(uint8_t pool);
+
+/**
+ * Returns the bytes of the pool blocks allocated now. These are not part of
+ * the nanostack heap statistics.
+ */
+uint32_t buffer_pools_bytes_in_use(void);
+
+/**
+ * Prints the pool counters and high-water marks.
+ */
+void buffer_pools_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BUFFER_POOLS_H */
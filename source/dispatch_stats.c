@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include "ns_types.h"
+#include "eventOS_event.h"
+#include "eventOS_event_timer.h"
+#include "net_interface.h"
+#include "hal/ticker_api.h"
+#include "hal/us_ticker_api.h"
+#include "platform/mbed_stats.h"
+#include "platform/arm_hal_interrupt.h"
+#include "dispatch_stats.h"
+
+#include "ns_trace.h"
+#define TRACE_GROUP "disp"
+
+#ifndef MBED_CONF_APP_DISPATCH_STATS
+#define MBED_CONF_APP_DISPATCH_STATS 0
+#endif
+
+#ifndef MBED_CONF_APP_DISPATCH_STATS_ENTRIES
+#define MBED_CONF_APP_DISPATCH_STATS_ENTRIES 16
+#endif
+
+#ifndef MBED_CONF_APP_DISPATCH_STATS_PROBE_MS
+#define MBED_CONF_APP_DISPATCH_STATS_PROBE_MS 1000
+#endif
+
+#ifndef MBED_CONF_APP_DISPATCH_STATS_LOAD_EVENTS
+#define MBED_CONF_APP_DISPATCH_STATS_LOAD_EVENTS 0
+#endif
+
+#ifndef MBED_CONF_APP_DISPATCH_STATS_LOAD_US
+#define MBED_CONF_APP_DISPATCH_STATS_LOAD_US 500
+#endif
+
+#if MBED_CONF_APP_DISPATCH_STATS_ENTRIES < 1 || MBED_CONF_APP_DISPATCH_STATS_ENTRIES > 0xffff
+#error "dispatch-stats-entries must be 1-65535"
+#endif
+
+#define PROBE_TIMER 1
+#define LOAD_EVENT 2
+
+/* Tasklets created through dispatch_stats_handler_create() */
+#define TIMED_TASKLETS_MAX 2
+
+typedef struct timed_tasklet {
+    int8_t tasklet_id;
+    void (*handler)(arm_event_s *);
+} timed_tasklet_t;
+
+static dispatch_stats_t stats;
+static dispatch_stats_entry_t entries[MBED_CONF_APP_DISPATCH_STATS_ENTRIES];
+static timed_tasklet_t timed_tasklets[TIMED_TASKLETS_MAX];
+static uint8_t timed_tasklet_count;
+static int8_t dispatch_tasklet_id = -1;
+#if defined(MBED_CPU_STATS_ENABLED)
+static mbed_stats_cpu_t cpu_prev;
+#endif
+
+static void histogram_add(dispatch_histogram_t *histogram, uint32_t value_us)
+{
+    uint32_t value = value_us;
+    uint8_t bucket = 0;
+
+    while (value >= 2 && bucket < DISPATCH_STATS_BUCKETS - 1) {
+        value >>= 1;
+        bucket++;
+    }
+    histogram->bucket[bucket]++;
+    histogram->count++;
+    if (value_us > histogram->max_us) {
+        histogram->max_us = value_us;
+    }
+}
+
+/* Upper bound of the bucket holding the given share of the samples */
+static uint32_t histogram_percentile(const dispatch_histogram_t *histogram, uint8_t percent)
+{
+    uint32_t target = (uint32_t)(((uint64_t)histogram->count * percent + 99) / 100);
+    uint32_t sum = 0;
+
+    for (uint8_t i = 0; i < DISPATCH_STATS_BUCKETS - 1; i++) {
+        sum += histogram->bucket[i];
+        if (sum >= target) {
+            uint32_t bound = (2UL << i) - 1;
+            return bound < histogram->max_us ? bound : histogram->max_us;
+        }
+    }
+    return histogram->max_us;
+}
+
+static void histogram_print(const char *name, const dispatch_histogram_t *histogram)
+{
+    if (histogram->count == 0) {
+        return;
+    }
+    tr_info("%s: n %lu, p50 <= %lu us, p99 <= %lu us, max %lu us", name,
+            (unsigned long)histogram->count,
+            (unsigned long)histogram_percentile(histogram, 50),
+            (unsigned long)histogram_percentile(histogram, 99),
+            (unsigned long)histogram->max_us);
+}
+
+static void idle_update(void)
+{
+#if defined(MBED_CPU_STATS_ENABLED)
+    mbed_stats_cpu_t cpu;
+    uint64_t uptime;
+
+    mbed_stats_cpu_get(&cpu);
+    uptime = cpu.uptime - cpu_prev.uptime;
+    if (uptime) {
+        stats.idle_permille = (uint16_t)((cpu.idle_time - cpu_prev.idle_time) * 1000 / uptime);
+        if (stats.idle_permille < stats.idle_permille_min) {
+            stats.idle_permille_min = stats.idle_permille;
+        }
+    }
+    cpu_prev = cpu;
+#endif
+}
+
+static uint32_t dispatch_stats_now(void)
+{
+    return (uint32_t) ticker_read_us(get_us_ticker_data());
+}
+
+/* Entry of a receiver, event type and ID, created on first use. NULL when all are taken. */
+static dispatch_stats_entry_t *entry_get(int8_t receiver, uint8_t event_type, uint8_t event_id)
+{
+    uint16_t i;
+
+    for (i = 0; i < stats.entry_count; i++) {
+        if (entries[i].receiver == receiver && entries[i].event_type == event_type &&
+                entries[i].event_id == event_id) {
+            return &entries[i];
+        }
+    }
+    if (i == MBED_CONF_APP_DISPATCH_STATS_ENTRIES) {
+        stats.entries_full++;
+        return NULL;
+    }
+    entries[i].receiver = receiver;
+    entries[i].event_type = event_type;
+    entries[i].event_id = event_id;
+    stats.entry_count++;
+    return &entries[i];
+}
+
+/* Driver callbacks send events from outside the event loop */
+static void entry_sent(int8_t receiver, uint8_t event_type, uint8_t event_id, uint32_t sent_us)
+{
+    dispatch_stats_entry_t *entry;
+
+    platform_enter_critical();
+    entry = entry_get(receiver, event_type, event_id);
+    if (entry) {
+        /* A second send before the dispatch is measured from the later one */
+        entry->sent = true;
+        entry->sent_us = sent_us;
+    }
+    platform_exit_critical();
+}
+
+/*
+ * Records the queue delay of an event dispatched at start_us. Called before
+ * the handler, which may send or request the same event again.
+ */
+static dispatch_stats_entry_t *entry_dispatched(const arm_event_s *event, uint32_t start_us)
+{
+    dispatch_stats_entry_t *entry;
+    uint32_t sent_us = 0;
+    bool sent = false;
+
+    platform_enter_critical();
+    entry = entry_get(event->receiver, event->event_type, event->event_id);
+    if (entry && entry->sent) {
+        entry->sent = false;
+        sent = true;
+        sent_us = entry->sent_us;
+    }
+    platform_exit_critical();
+
+    if (entry && sent) {
+        histogram_add(&entry->queue_delay, (int32_t)(start_us - sent_us) > 0 ? start_us - sent_us : 0);
+    }
+    return entry;
+}
+
+/* Records the run time of a handler that started at start_us */
+static void entry_finished(dispatch_stats_entry_t *entry, uint32_t start_us)
+{
+    if (entry) {
+        histogram_add(&entry->run_time, dispatch_stats_now() - start_us);
+    }
+}
+
+static void dispatch_timed(arm_event_s *event)
+{
+    uint32_t start = dispatch_stats_now();
+    dispatch_stats_entry_t *entry;
+
+    for (uint8_t i = 0; i < timed_tasklet_count; i++) {
+        if (timed_tasklets[i].tasklet_id == event->receiver) {
+            entry = entry_dispatched(event, start);
+            timed_tasklets[i].handler(event);
+            entry_finished(entry, start);
+            return;
+        }
+    }
+}
+
+static void load_event_send(void)
+{
+    arm_event_s event = {
+        .sender = dispatch_tasklet_id,
+        .receiver = dispatch_tasklet_id,
+        .priority = ARM_LIB_LOW_PRIORITY_EVENT,
+        .event_type = APPLICATION_EVENT,
+        .event_id = LOAD_EVENT,
+    };
+
+    dispatch_stats_event_send(&event);
+}
+
+static void dispatch_tasklet(arm_event_s *event)
+{
+    uint32_t start = dispatch_stats_now();
+
+    switch (event->event_type) {
+        case ARM_LIB_TASKLET_INIT_EVENT:
+            dispatch_tasklet_id = event->receiver;
+            eventOS_event_timer_request(PROBE_TIMER, ARM_LIB_SYSTEM_TIMER_EVENT, dispatch_tasklet_id,
+                                        MBED_CONF_APP_DISPATCH_STATS_PROBE_MS);
+            break;
+
+        case ARM_LIB_SYSTEM_TIMER_EVENT:
+            if (event->event_id != PROBE_TIMER) {
+                break;
+            }
+            idle_update();
+
+            /* Synthetic load for benchmarking: events that keep the loop busy */
+            for (uint16_t i = 0; i < MBED_CONF_APP_DISPATCH_STATS_LOAD_EVENTS; i++) {
+                load_event_send();
+            }
+            eventOS_event_timer_request(PROBE_TIMER, ARM_LIB_SYSTEM_TIMER_EVENT, dispatch_tasklet_id,
+                                        MBED_CONF_APP_DISPATCH_STATS_PROBE_MS);
+            break;
+
+        case APPLICATION_EVENT:
+            if (event->event_id == LOAD_EVENT) {
+                dispatch_stats_entry_t *entry = entry_dispatched(event, start);
+                while (dispatch_stats_now() - start < MBED_CONF_APP_DISPATCH_STATS_LOAD_US) {
+                }
+                entry_finished(entry, start);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void dispatch_stats_start(void)
+{
+    if (!MBED_CONF_APP_DISPATCH_STATS || dispatch_tasklet_id >= 0) {
+        return;
+    }
+
+    stats.idle_permille = 1000;
+    stats.idle_permille_min = 1000;
+    stats.entries = entries;
+#if defined(MBED_CPU_STATS_ENABLED)
+    mbed_stats_cpu_get(&cpu_prev);
+#endif
+
+    eventOS_event_handler_create(&dispatch_tasklet, ARM_LIB_TASKLET_INIT_EVENT);
+}
+
+int8_t dispatch_stats_handler_create(void (*handler)(arm_event_s *), uint8_t init_event_type)
+{
+    int8_t tasklet_id;
+
+    if (!MBED_CONF_APP_DISPATCH_STATS || timed_tasklet_count == TIMED_TASKLETS_MAX) {
+        return eventOS_event_handler_create(handler, init_event_type);
+    }
+
+    /* The init event is queued, it is dispatched only after the tasklet is known here */
+    tasklet_id = eventOS_event_handler_create(&dispatch_timed, init_event_type);
+    if (tasklet_id >= 0) {
+        timed_tasklets[timed_tasklet_count].tasklet_id = tasklet_id;
+        timed_tasklets[timed_tasklet_count].handler = handler;
+        timed_tasklet_count++;
+    }
+    return tasklet_id;
+}
+
+int8_t dispatch_stats_event_send(const arm_event_s *event)
+{
+    if (MBED_CONF_APP_DISPATCH_STATS) {
+        entry_sent(event->receiver, event->event_type, event->event_id, dispatch_stats_now());
+    }
+    return eventOS_event_send(event);
+}
+
+int8_t dispatch_stats_timer_request(uint8_t event_id, uint8_t event_type, int8_t tasklet_id, uint32_t time_ms)
+{
+    if (MBED_CONF_APP_DISPATCH_STATS) {
+        entry_sent(tasklet_id, event_type, event_id, dispatch_stats_now() + time_ms * 1000UL);
+    }
+    return eventOS_event_timer_request(event_id, event_type, tasklet_id, time_ms);
+}
+
+int8_t dispatch_stats_timer_cancel(uint8_t event_id, int8_t tasklet_id)
+{
+    if (MBED_CONF_APP_DISPATCH_STATS) {
+        /* The timer may be of any event type, forget all sends of the ID */
+        platform_enter_critical();
+        for (uint16_t i = 0; i < stats.entry_count; i++) {
+            if (entries[i].receiver == tasklet_id && entries[i].event_id == event_id) {
+                entries[i].sent = false;
+            }
+        }
+        platform_exit_critical();
+    }
+    return eventOS_event_timer_cancel(event_id, tasklet_id);
+}
+
+const dispatch_stats_t *dispatch_stats_get(void)
+{
+    return &stats;
+}
+
+void dispatch_stats_print(void)
+{
+    char name[40];
+
+    if (!MBED_CONF_APP_DISPATCH_STATS) {
+        return;
+    }
+
+    for (uint16_t i = 0; i < stats.entry_count; i++) {
+        snprintf(name, sizeof(name), "Queue tasklet %d type %u id %u", entries[i].receiver,
+                 entries[i].event_type, entries[i].event_id);
+        histogram_print(name, &entries[i].queue_delay);
+        snprintf(name, sizeof(name), "Run tasklet %d type %u id %u", entries[i].receiver,
+                 entries[i].event_type, entries[i].event_id);
+        histogram_print(name, &entries[i].run_time);
+    }
+#if defined(MBED_CPU_STATS_ENABLED)
+    tr_info("CPU idle %u.%u%%, lowest %u.%u%%", stats.idle_permille / 10, stats.idle_permille % 10,
+            stats.idle_permille_min / 10, stats.idle_permille_min % 10);
+#endif
+    if (stats.entries_full) {
+        tr_warn("%lu events not recorded, increase dispatch-stats-entries", (unsigned long)stats.entries_full);
+    }
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#ifndef DISPATCH_STATS_H
+#define DISPATCH_STATS_H
+
+#include "ns_types.h"
+#include "eventOS_event.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define DISPATCH_STATS_BUCKETS 16
+
+/** Bucket n counts values of 2^n to 2^(n+1)-1 us, bucket 0 also 0 us and the last one all above */
+typedef struct dispatch_histogram {
+    uint32_t count;
+    uint32_t max_us;
+    uint32_t bucket[DISPATCH_STATS_BUCKETS];
+} dispatch_histogram_t;
+
+/** Queue delay and handler run time of one receiver, event type and ID */
+typedef struct dispatch_stats_entry {
+    int8_t receiver;
+    uint8_t event_type;
+    uint8_t event_id;
+    bool sent;                          /**< Such an event is queued or its timer runs, sent_us is valid */
+    uint32_t sent_us;                   /**< When the last one was sent, or when its timer was due */
+    dispatch_histogram_t queue_delay;   /**< Send, or timer due time, to dispatch */
+    dispatch_histogram_t run_time;
+} dispatch_stats_entry_t;
+
+typedef struct dispatch_stats {
+    uint16_t idle_permille;             /**< CPU idle in the last probe interval, 1000 if unknown */
+    uint16_t idle_permille_min;         /**< Lowest idle seen */
+    uint16_t entry_count;
+    uint32_t entries_full;              /**< Events not recorded because all entries were taken */
+    const dispatch_stats_entry_t *entries;
+} dispatch_stats_t;
+
+/**
+ * Starts the CPU idle probe and the optional synthetic load. Does nothing
+ * unless "dispatch-stats" is enabled.
+ */
+void dispatch_stats_start(void);
+
+/**
+ * Creates a tasklet like eventOS_event_handler_create(). With
+ * "dispatch-stats" enabled, the queue delay and run time of every event
+ * dispatched to it are recorded.
+ */
+int8_t dispatch_stats_handler_create(void (*handler)(arm_event_s *), uint8_t init_event_type);
+
+/**
+ * Sends an event like eventOS_event_send() and notes the send time for the
+ * queue delay of its type and ID.
+ */
+int8_t dispatch_stats_event_send(const arm_event_s *event);
+
+/**
+ * Requests a timer like eventOS_event_timer_request() and notes its due
+ * time for the queue delay of its type and ID.
+ */
+int8_t dispatch_stats_timer_request(uint8_t event_id, uint8_t event_type, int8_t tasklet_id, uint32_t time_ms);
+
+/**
+ * Cancels a timer like eventOS_event_timer_cancel() and forgets its due
+ * time. Use it for timers requested with dispatch_stats_timer_request().
+ */
+int8_t dispatch_stats_timer_cancel(uint8_t event_id, int8_t tasklet_id);
+
+/**
+ * Returns the histograms collected so far.
+ */
+const dispatch_stats_t *dispatch_stats_get(void);
+
+/**
+ * Prints the histograms as 50th and 99th percentile upper bounds.
+ */
+void dispatch_stats_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DISPATCH_STATS_H */
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#include <string.h>
+#include "ns_types.h"
+#include "common_functions.h"
+#include "eventOS_event.h"
+#include "eventOS_event_timer.h"
+#include "net_interface.h"
+#include "ip6string.h"
+#include "borderrouter_helpers.h"
+#include "iphc_contexts.h"
+
+#include "ns_trace.h"
+#define TRACE_GROUP "iphc"
+
+#define IPHC_CONTEXT_MAX 16
+#define IPHC_CONTEXT_INTERFACES_MAX 4
+#define IPHC_CONTEXT_COMPRESS 0x10
+
+#define IPHC_CONTEXT_TIMER 1
+#define IPHC_CONTEXT_TICK_MS 60000
+
+/* Minutes a new or changed prefix is advertised without compression */
+#ifndef MBED_CONF_APP_IPHC_CONTEXT_GRACE_MIN
+#define MBED_CONF_APP_IPHC_CONTEXT_GRACE_MIN 2
+#endif
+
+#if MBED_CONF_APP_IPHC_CONTEXT_GRACE_MIN < 1
+#error "iphc-context-grace-min must be at least 1"
+#endif
+
+typedef struct {
+    uint8_t prefix[16];
+    uint8_t prefix_len;
+    bool in_use;
+    bool compress;
+    uint16_t lifetime_min;
+    uint16_t refresh_in_min;        /**< Minutes until the lifetime is advertised again */
+    uint16_t compress_in_min;       /**< Ticks until compression is enabled after a change */
+} iphc_context_t;
+
+#ifdef MBED_CONF_APP_IPHC_CONTEXTS
+static const iphc_context_config_t context_config[] = MBED_CONF_APP_IPHC_CONTEXTS;
+#endif
+
+/* Indexed by context ID */
+static iphc_context_t contexts[IPHC_CONTEXT_MAX];
+static int8_t interfaces[IPHC_CONTEXT_INTERFACES_MAX];
+static uint8_t interface_count;
+static int8_t iphc_tasklet_id = -1;
+
+static void context_install(int8_t interface_id, uint8_t cid)
+{
+    const iphc_context_t *context = &contexts[cid];
+    uint8_t flags = cid | (context->compress ? IPHC_CONTEXT_COMPRESS : 0);
+    uint8_t prefix[16];
+
+    memcpy(prefix, context->prefix, 16);
+    if (arm_nwk_6lowpan_border_router_context_update(interface_id, flags, context->prefix_len,
+                                                     context->lifetime_min, prefix) != 0) {
+        tr_error("Context %u update failed on interface %d", cid, interface_id);
+    }
+}
+
+/* Installs one context on all interfaces and pushes the change to the nodes */
+static void context_advertise(uint8_t cid)
+{
+    for (uint8_t i = 0; i < interface_count; i++) {
+        context_install(interfaces[i], cid);
+        arm_nwk_6lowpan_border_router_configure_push(interfaces[i]);
+    }
+    contexts[cid].refresh_in_min = contexts[cid].lifetime_min / 2;
+}
+
+static void contexts_tick(void)
+{
+    for (uint8_t cid = 0; cid < IPHC_CONTEXT_MAX; cid++) {
+        iphc_context_t *context = &contexts[cid];
+        bool changed = false;
+
+        if (!context->in_use) {
+            continue;
+        }
+
+        if (context->compress_in_min && --context->compress_in_min == 0) {
+            context->compress = true;
+            tr_info("Context %u compression on", cid);
+            changed = true;
+        }
+
+        if (context->refresh_in_min == 0 || --context->refresh_in_min == 0) {
+            changed = true;
+        }
+
+        if (changed) {
+            context_advertise(cid);
+        }
+    }
+}
+
+static void iphc_tasklet(arm_event_s *event)
+{
+    switch (event->event_type) {
+        case ARM_LIB_TASKLET_INIT_EVENT:
+            iphc_tasklet_id = event->receiver;
+            eventOS_event_timer_request(IPHC_CONTEXT_TIMER, ARM_LIB_SYSTEM_TIMER_EVENT,
+                                        iphc_tasklet_id, IPHC_CONTEXT_TICK_MS);
+            break;
+
+        case ARM_LIB_SYSTEM_TIMER_EVENT:
+            if (event->event_id == IPHC_CONTEXT_TIMER) {
+                contexts_tick();
+                eventOS_event_timer_request(IPHC_CONTEXT_TIMER, ARM_LIB_SYSTEM_TIMER_EVENT,
+                                            iphc_tasklet_id, IPHC_CONTEXT_TICK_MS);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void iphc_contexts_init(void)
+{
+#ifdef MBED_CONF_APP_IPHC_CONTEXTS
+    for (uint8_t i = 0; i < sizeof(context_config) / sizeof(context_config[0]); i++) {
+        const iphc_context_config_t *config = &context_config[i];
+        uint8_t prefix[16];
+
+        if (!stoip6(config->prefix, strlen(config->prefix), prefix) ||
+                iphc_context_set(config->cid, prefix, config->prefix_len, config->lifetime_min) != 0) {
+            tr_error("Invalid IPHC context %u \"%s\"", config->cid, config->prefix);
+        }
+    }
+#endif
+
+    if (iphc_tasklet_id < 0) {
+        eventOS_event_handler_create(&iphc_tasklet, ARM_LIB_TASKLET_INIT_EVENT);
+    }
+}
+
+void iphc_contexts_interface_add(int8_t interface_id)
+{
+    uint8_t i;
+
+    for (i = 0; i < interface_count; i++) {
+        if (interfaces[i] == interface_id) {
+            break;
+        }
+    }
+    if (i == interface_count) {
+        if (interface_count == IPHC_CONTEXT_INTERFACES_MAX) {
+            tr_error("Too many interfaces for IPHC contexts");
+            return;
+        }
+        interfaces[interface_count++] = interface_id;
+    }
+
+    /* The interface may have been restarted, contexts are installed again */
+    for (uint8_t cid = 0; cid < IPHC_CONTEXT_MAX; cid++) {
+        if (contexts[cid].in_use) {
+            context_install(interface_id, cid);
+        }
+    }
+}
+
+int iphc_context_set(uint8_t cid, const uint8_t prefix[16], uint8_t prefix_len, uint16_t lifetime_min)
+{
+    iphc_context_t *context;
+    bool prefix_changed;
+
+    if (cid >= IPHC_CONTEXT_MAX || (IPHC_CONTEXT_RESERVED_MASK & (1 << cid)) ||
+            prefix_len == 0 || prefix_len > 128 || lifetime_min == 0) {
+        return -1;
+    }
+
+    context = &contexts[cid];
+    prefix_changed = !context->in_use || context->prefix_len != prefix_len ||
+                     !bitsequal(context->prefix, prefix, prefix_len);
+
+    if (prefix_changed) {
+        memset(context->prefix, 0, 16);
+        bitcopy(context->prefix, prefix, prefix_len);
+        context->prefix_len = prefix_len;
+        /* RFC 6775 7.2: nodes learn the prefix from C=0 advertisements before it is used */
+        context->compress = false;
+        /* The free-running tick may come right after the change, one more keeps the full grace period */
+        context->compress_in_min = MBED_CONF_APP_IPHC_CONTEXT_GRACE_MIN + 1;
+        context->in_use = true;
+    }
+    context->lifetime_min = lifetime_min;
+
+    tr_info_lazy("Context %u: %s, lifetime %u min", cid, tr_ipv6_prefix(context->prefix, prefix_len), lifetime_min);
+    context_advertise(cid);
+    return 0;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#ifndef IPHC_CONTEXTS_H
+#define IPHC_CONTEXTS_H
+
+#include "ns_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Context IDs the ND border router uses itself: ND prefix, backhaul prefix and DODAG ID */
+#define IPHC_CONTEXT_RESERVED_MASK ((1 << 0) | (1 << 1) | (1 << 3))
+
+/** One entry of the "iphc-contexts" configuration */
+typedef struct iphc_context_config {
+    uint8_t cid;                    /**< Context ID, 0-15, not reserved */
+    const char *prefix;             /**< Prefix or address, for example "2001:db8::53" */
+    uint8_t prefix_len;             /**< Prefix length in bits */
+    uint16_t lifetime_min;          /**< Lifetime advertised to the nodes */
+} iphc_context_config_t;
+
+/**
+ * Loads the contexts from "iphc-contexts" and starts the lifetime refresh.
+ */
+void iphc_contexts_init(void);
+
+/**
+ * Installs all contexts on a border router interface. Call after
+ * arm_nwk_6lowpan_border_router_init().
+ */
+void iphc_contexts_interface_add(int8_t interface_id);
+
+/**
+ * Adds a context or changes an existing one in place.
+ *
+ * A new or changed prefix is first advertised with compression disabled
+ * and compression is enabled only after a grace period, so that every node
+ * has the prefix before it is used, and nodes still holding an old prefix
+ * never decompress with it.
+ *
+ * \return 0 on success, -1 on a reserved or invalid context ID
+ */
+int iphc_context_set(uint8_t cid, const uint8_t prefix[16], uint8_t prefix_len, uint16_t lifetime_min);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IPHC_CONTEXTS_H */
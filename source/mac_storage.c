@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#include "ns_types.h"
+#include "nsdynmemLIB.h"
+#include "mac_api.h"
+#include "mac_storage.h"
+
+#include "ns_trace.h"
+#define TRACE_GROUP "macs"
+
+#if MBED_CONF_APP_MAC_DEVICE_TABLE_SIZE > MAC_DEVICE_TABLE_MAX
+#error "mac-device-table-size is limited to 255 by the MAC"
+#endif
+
+/* Used when the table is sized from the heap budget but heap statistics are not enabled */
+#define MAC_DEVICE_TABLE_DEFAULT 40
+
+uint32_t mac_storage_neighbour_cost(const mac_description_storage_size_t *sizes)
+{
+    return MAC_STORAGE_NEIGHBOUR_COST(sizes->key_description_table_size);
+}
+
+uint32_t mac_storage_heap_allocated(void)
+{
+    const mem_stat_t *heap_info = ns_dyn_mem_get_mem_stat();
+
+    return heap_info ? heap_info->heap_sector_allocated_bytes : 0;
+}
+
+void mac_storage_sizes_get(mac_description_storage_size_t *sizes, uint8_t key_descriptions,
+                           uint8_t key_lookups, uint8_t key_usages)
+{
+    const mem_stat_t *heap_info = ns_dyn_mem_get_mem_stat();
+    uint32_t devices = MBED_CONF_APP_MAC_DEVICE_TABLE_SIZE;
+
+#ifdef MBED_CONF_APP_MAC_KEY_DESCRIPTION_TABLE_SIZE
+    key_descriptions = MBED_CONF_APP_MAC_KEY_DESCRIPTION_TABLE_SIZE;
+#endif
+#ifdef MBED_CONF_APP_MAC_KEY_LOOKUP_SIZE
+    key_lookups = MBED_CONF_APP_MAC_KEY_LOOKUP_SIZE;
+#endif
+#ifdef MBED_CONF_APP_MAC_KEY_USAGE_SIZE
+    key_usages = MBED_CONF_APP_MAC_KEY_USAGE_SIZE;
+#endif
+
+    sizes->key_description_table_size = key_descriptions;
+    sizes->key_lookup_size = key_lookups;
+    sizes->key_usage_size = key_usages;
+
+    if (heap_info) {
+        /* Every neighbour also takes stack state outside the MAC, see "neighbour-heap-cost" */
+        uint32_t budget = heap_info->heap_sector_size / 100 * MBED_CONF_APP_MAC_HEAP_BUDGET_PERCENT;
+        uint32_t max = budget / (mac_storage_neighbour_cost(sizes) + MBED_CONF_APP_NEIGHBOUR_HEAP_COST);
+
+        if (max > MAC_DEVICE_TABLE_MAX) {
+            max = MAC_DEVICE_TABLE_MAX;
+        } else if (max < MAC_DEVICE_TABLE_MIN) {
+            max = MAC_DEVICE_TABLE_MIN;
+        }
+
+        if (devices == 0) {
+            devices = max;
+        } else if (devices > max) {
+            tr_warn("mac-device-table-size %lu does not fit the heap budget of %lu bytes, using %lu",
+                    (unsigned long)devices, (unsigned long)budget, (unsigned long)max);
+            devices = max;
+        }
+    } else if (devices == 0) {
+        devices = MAC_DEVICE_TABLE_DEFAULT;
+    }
+
+    sizes->device_decription_table_size = devices;
+}
+
+void mac_storage_report(const mac_description_storage_size_t *sizes, uint32_t heap_before)
+{
+    uint32_t heap_after = mac_storage_heap_allocated();
+
+    tr_info("MAC tables: %u neighbours, %u keys, %lu bytes per neighbour, MAC heap %lu bytes",
+            sizes->device_decription_table_size, sizes->key_description_table_size,
+            (unsigned long)mac_storage_neighbour_cost(sizes),
+            (unsigned long)(heap_after > heap_before ? heap_after - heap_before : 0));
+}
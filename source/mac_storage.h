@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#ifndef MAC_STORAGE_H
+#define MAC_STORAGE_H
+
+#include "ns_types.h"
+#include "mac_api.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifndef MBED_CONF_APP_MAC_DEVICE_TABLE_SIZE
+#define MBED_CONF_APP_MAC_DEVICE_TABLE_SIZE 40
+#endif
+
+#ifndef MBED_CONF_APP_MAC_HEAP_BUDGET_PERCENT
+#define MBED_CONF_APP_MAC_HEAP_BUDGET_PERCENT 25
+#endif
+
+#ifndef MBED_CONF_APP_NEIGHBOUR_HEAP_COST
+#define MBED_CONF_APP_NEIGHBOUR_HEAP_COST 256
+#endif
+
+/* mac_description_storage_size_t holds the device table size in a uint8_t */
+#define MAC_DEVICE_TABLE_MAX 255
+#define MAC_DEVICE_TABLE_MIN 8
+
+/*
+ * MAC security table bytes of one device table entry. The MAC allocates one
+ * device descriptor per entry, and every key keeps a usage flag for every device.
+ */
+#define MAC_STORAGE_NEIGHBOUR_COST(key_descriptions) \
+    (sizeof(mlme_device_descriptor_t) + (key_descriptions) * sizeof(mlme_key_device_descriptor_t))
+
+/**
+ * Fills the MAC security table sizes for ns_sw_mac_create(). The key table
+ * sizes are the mesh mode defaults unless "mac-key-*" is set. The device
+ * table size is "mac-device-table-size", limited to what fits the share of
+ * the nanostack heap set by "mac-heap-budget-percent".
+ *
+ * \param sizes Sizes to fill
+ * \param key_descriptions Mesh mode default of key_description_table_size
+ * \param key_lookups Mesh mode default of key_lookup_size
+ * \param key_usages Mesh mode default of key_usage_size
+ */
+void mac_storage_sizes_get(mac_description_storage_size_t *sizes, uint8_t key_descriptions,
+                           uint8_t key_lookups, uint8_t key_usages);
+
+/**
+ * Returns the MAC security table bytes each device table entry takes.
+ */
+uint32_t mac_storage_neighbour_cost(const mac_description_storage_size_t *sizes);
+
+/**
+ * Returns the allocated nanostack heap, 0 if heap statistics are not enabled.
+ */
+uint32_t mac_storage_heap_allocated(void);
+
+/**
+ * Traces the heap ns_sw_mac_create() took and the cost of one neighbour.
+ *
+ * \param sizes Sizes the MAC was created with
+ * \param heap_before mac_storage_heap_allocated() before ns_sw_mac_create()
+ */
+void mac_storage_report(const mac_description_storage_size_t *sizes, uint32_t heap_before);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MAC_STORAGE_H */
@@ -0,0 +1,420 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#include <string.h>
+#include "ns_types.h"
+#include "nsdynmemLIB.h"
+#include "common_functions.h"
+#include "eventOS_event.h"
+#include "eventOS_event_timer.h"
+#include "net_interface.h"
+#include "platform/arm_hal_phy.h"
+#include "platform/arm_hal_interrupt.h"
+#include "memory_pressure.h"
+
+#include "ns_trace.h"
+#define TRACE_GROUP "mprs"
+
+#ifndef MBED_CONF_APP_MEMORY_PRESSURE
+#define MBED_CONF_APP_MEMORY_PRESSURE 0
+#endif
+
+#ifndef MBED_CONF_APP_MEMORY_PRESSURE_POLL_MS
+#define MBED_CONF_APP_MEMORY_PRESSURE_POLL_MS 1000
+#endif
+
+#ifndef MBED_CONF_APP_MEMORY_PRESSURE_DUMPS_WATERMARK
+#define MBED_CONF_APP_MEMORY_PRESSURE_DUMPS_WATERMARK 70
+#endif
+
+#ifndef MBED_CONF_APP_MEMORY_PRESSURE_JOINS_WATERMARK
+#define MBED_CONF_APP_MEMORY_PRESSURE_JOINS_WATERMARK 75
+#endif
+
+#ifndef MBED_CONF_APP_MEMORY_PRESSURE_DOWNLINK_WATERMARK
+#define MBED_CONF_APP_MEMORY_PRESSURE_DOWNLINK_WATERMARK 85
+#endif
+
+#ifndef MBED_CONF_APP_MEMORY_PRESSURE_LIFETIME_WATERMARK
+#define MBED_CONF_APP_MEMORY_PRESSURE_LIFETIME_WATERMARK 90
+#endif
+
+#ifndef MBED_CONF_APP_MEMORY_PRESSURE_HYSTERESIS
+#define MBED_CONF_APP_MEMORY_PRESSURE_HYSTERESIS 10
+#endif
+
+#ifndef MBED_CONF_APP_MEMORY_PRESSURE_HOLD_MS
+#define MBED_CONF_APP_MEMORY_PRESSURE_HOLD_MS 30000
+#endif
+
+#ifndef MBED_CONF_APP_MEMORY_PRESSURE_JOIN_INTERVAL_MS
+#define MBED_CONF_APP_MEMORY_PRESSURE_JOIN_INTERVAL_MS 10000
+#endif
+
+#ifndef MBED_CONF_APP_MEMORY_PRESSURE_DOWNLINK_FRAMES
+#define MBED_CONF_APP_MEMORY_PRESSURE_DOWNLINK_FRAMES 2
+#endif
+
+#ifndef MBED_CONF_APP_INDIRECT_BIG_PACKET_THRESHOLD
+#define MBED_CONF_APP_INDIRECT_BIG_PACKET_THRESHOLD 50
+#endif
+
+#ifndef MBED_CONF_APP_INDIRECT_SMALL_PACKETS_PER_CHILD
+#define MBED_CONF_APP_INDIRECT_SMALL_PACKETS_PER_CHILD 2
+#endif
+
+#ifndef MBED_CONF_APP_INDIRECT_BIG_PACKETS_TOTAL
+#define MBED_CONF_APP_INDIRECT_BIG_PACKETS_TOTAL 10
+#endif
+
+#define POLL_TIMER 1
+#define ACTION_COUNT 4
+#define JOIN_GATE_MAX 4
+#define HOLD_POLLS (MBED_CONF_APP_MEMORY_PRESSURE_HOLD_MS / MBED_CONF_APP_MEMORY_PRESSURE_POLL_MS)
+
+/* IEEE 802.15.4 frame control fields */
+#define FCF_FRAME_TYPE_MASK     0x0007
+#define FCF_SECURITY            0x0008
+#define FCF_PAN_ID_COMPRESSION  0x0040
+#define FCF_SEQ_SUPPRESSION     0x0100
+#define FCF_IE_PRESENT          0x0200
+#define FRAME_TYPE_DATA         1
+#define FRAME_TYPE_COMMAND      3
+#define FRAME_VERSION_2015      2
+#define MAC_CMD_BEACON_REQUEST  0x07
+
+/* Wi-SUN frame type in the UTT-IE of the Wi-SUN header IE */
+#define IE_ID_WISUN             0x2a
+#define IE_ID_TERMINATION_1     0x7e
+#define IE_ID_TERMINATION_2     0x7f
+#define WH_IE_SUB_ID_UTT        0x01
+#define WS_FT_PAS               1
+
+typedef struct pressure_action {
+    uint8_t action;
+    uint8_t watermark;
+    const char *name;
+    const char *taken;
+    const char *released;
+} pressure_action_t;
+
+/* In the order the actions are taken when allocations fail */
+static const pressure_action_t actions[ACTION_COUNT] = {
+    {
+        MEMORY_PRESSURE_DUMPS, MBED_CONF_APP_MEMORY_PRESSURE_DUMPS_WATERMARK,
+        "debug dump suspension", "debug dumps suspended", "debug dumps resumed"
+    },
+    {
+        MEMORY_PRESSURE_JOINS, MBED_CONF_APP_MEMORY_PRESSURE_JOINS_WATERMARK,
+        "join throttling", "joins throttled", "joins resumed"
+    },
+    {
+        MEMORY_PRESSURE_DOWNLINK, MBED_CONF_APP_MEMORY_PRESSURE_DOWNLINK_WATERMARK,
+        "downlink queue cap", "downlink queues capped", "downlink queues restored"
+    },
+    {
+        MEMORY_PRESSURE_LIFETIME, MBED_CONF_APP_MEMORY_PRESSURE_LIFETIME_WATERMARK,
+        "DAO route lifetime shortening", "DAO route lifetimes shortened", "DAO route lifetimes restored"
+    },
+};
+
+typedef struct join_gate {
+    int8_t driver_id;
+    arm_net_phy_rx_fn *rx_cb;
+} join_gate_t;
+
+static memory_pressure_stats_t stats;
+static memory_pressure_action_cb *mode_action_cb;
+static uint16_t hold_polls[ACTION_COUNT];
+static uint32_t alloc_fails_prev;
+static int8_t pressure_tasklet_id = -1;
+
+static join_gate_t join_gates[JOIN_GATE_MAX];
+static uint8_t join_gate_count;
+static uint32_t join_pass_ticks;
+static bool join_passed;
+
+static void action_set(const pressure_action_t *action, bool active, uint32_t alloc_fails)
+{
+    bool supported = true;
+
+    /* The mode sees the new state in memory_pressure_active() */
+    if (active) {
+        stats.active |= action->action;
+        stats.activations++;
+    } else {
+        stats.active &= ~action->action;
+    }
+
+    if (action->action != MEMORY_PRESSURE_DUMPS && mode_action_cb) {
+        supported = mode_action_cb(action->action, active);
+    }
+
+    if (!supported) {
+        if (active) {
+            tr_info("Memory pressure: heap %u%% in use, %s not available in this mesh mode",
+                    stats.heap_percent, action->name);
+        }
+    } else if (alloc_fails) {
+        tr_warn("Memory pressure: heap %u%% in use, %lu allocations failed, %s",
+                stats.heap_percent, (unsigned long)alloc_fails, action->taken);
+    } else if (active) {
+        tr_warn("Memory pressure: heap %u%% in use, %s", stats.heap_percent, action->taken);
+    } else {
+        tr_info("Memory pressure: heap %u%% in use, %s", stats.heap_percent, action->released);
+    }
+}
+
+/*
+ * Each action is taken when the heap use reaches its watermark, and released
+ * when the use falls the hysteresis below it after the hold time. New
+ * allocation failures take the next action at once, whatever the heap use,
+ * since fragmentation makes them fail well below the watermarks.
+ */
+static void pressure_poll(void)
+{
+    const mem_stat_t *heap_info = ns_dyn_mem_get_mem_stat();
+    uint32_t alloc_fails = heap_info->heap_alloc_fail_cnt - alloc_fails_prev;
+
+    alloc_fails_prev = heap_info->heap_alloc_fail_cnt;
+    stats.heap_percent = (uint8_t)((uint64_t)heap_info->heap_sector_allocated_bytes * 100 /
+                                   heap_info->heap_sector_size);
+    if (stats.heap_percent > stats.heap_percent_max) {
+        stats.heap_percent_max = stats.heap_percent;
+    }
+
+    for (uint8_t i = 0; i < ACTION_COUNT; i++) {
+        const pressure_action_t *action = &actions[i];
+
+        if (!(stats.active & action->action)) {
+            if (stats.heap_percent >= action->watermark) {
+                action_set(action, true, 0);
+                hold_polls[i] = HOLD_POLLS;
+            } else if (alloc_fails) {
+                action_set(action, true, alloc_fails);
+                hold_polls[i] = HOLD_POLLS;
+                alloc_fails = 0;
+            }
+        } else if (hold_polls[i]) {
+            hold_polls[i]--;
+        } else if (stats.heap_percent + MBED_CONF_APP_MEMORY_PRESSURE_HYSTERESIS < action->watermark) {
+            action_set(action, false, 0);
+        }
+    }
+}
+
+static void pressure_tasklet(arm_event_s *event)
+{
+    switch (event->event_type) {
+        case ARM_LIB_TASKLET_INIT_EVENT:
+            pressure_tasklet_id = event->receiver;
+            break;
+
+        case ARM_LIB_SYSTEM_TIMER_EVENT:
+            if (event->event_id != POLL_TIMER) {
+                return;
+            }
+            pressure_poll();
+            break;
+
+        default:
+            return;
+    }
+    eventOS_event_timer_request(POLL_TIMER, ARM_LIB_SYSTEM_TIMER_EVENT, pressure_tasklet_id,
+                                MBED_CONF_APP_MEMORY_PRESSURE_POLL_MS);
+}
+
+/* Frames a node sends to find a network to join */
+static bool join_request(const uint8_t *ptr, uint16_t len)
+{
+    static const uint8_t addr_len[4] = {0, 0, 2, 8};
+    uint16_t fcf;
+    uint8_t dst_mode;
+    uint8_t src_mode;
+    bool compression;
+    bool dst_pan;
+    bool src_pan;
+    uint16_t off = 2;
+
+    if (len < 3) {
+        return false;
+    }
+    fcf = common_read_16_bit_inverse(ptr);
+    dst_mode = (fcf >> 10) & 3;
+    src_mode = (fcf >> 14) & 3;
+    compression = fcf & FCF_PAN_ID_COMPRESSION;
+
+    /* Both are sent before the node has any keys */
+    if (fcf & FCF_SECURITY) {
+        return false;
+    }
+
+    if (((fcf >> 12) & 3) != FRAME_VERSION_2015) {
+        off++;
+        dst_pan = dst_mode != 0;
+        src_pan = src_mode != 0 && !compression;
+    } else {
+        if (!(fcf & FCF_SEQ_SUPPRESSION)) {
+            off++;
+        }
+        /* PAN ID presence, IEEE 802.15.4-2015 table 7-2 */
+        if (!dst_mode && !src_mode) {
+            dst_pan = compression;
+            src_pan = false;
+        } else if (!src_mode) {
+            dst_pan = !compression;
+            src_pan = false;
+        } else if (!dst_mode) {
+            dst_pan = false;
+            src_pan = !compression;
+        } else if (dst_mode == 3 && src_mode == 3) {
+            dst_pan = !compression;
+            src_pan = false;
+        } else {
+            dst_pan = true;
+            src_pan = !compression;
+        }
+    }
+    off += (dst_pan ? 2 : 0) + addr_len[dst_mode] + (src_pan ? 2 : 0) + addr_len[src_mode];
+
+    if ((fcf & FCF_FRAME_TYPE_MASK) == FRAME_TYPE_COMMAND) {
+        return !(fcf & FCF_IE_PRESENT) && off < len && ptr[off] == MAC_CMD_BEACON_REQUEST;
+    }
+    if ((fcf & FCF_FRAME_TYPE_MASK) != FRAME_TYPE_DATA || !(fcf & FCF_IE_PRESENT)) {
+        return false;
+    }
+
+    /* Header IEs up to the payload IEs or a termination IE */
+    while (off + 2 <= len) {
+        uint16_t ie = common_read_16_bit_inverse(&ptr[off]);
+        uint8_t ie_len = ie & 0x7f;
+        uint8_t ie_id = (ie >> 7) & 0xff;
+
+        off += 2;
+        if ((ie & 0x8000) || ie_id == IE_ID_TERMINATION_1 || ie_id == IE_ID_TERMINATION_2) {
+            break;
+        }
+        if (ie_id == IE_ID_WISUN && ie_len >= 2 && off + 2 <= len && ptr[off] == WH_IE_SUB_ID_UTT) {
+            return (ptr[off + 1] & 0x0f) == WS_FT_PAS;
+        }
+        off += ie_len;
+    }
+    return false;
+}
+
+/* One join request per interval, the stack answers it as usual */
+static bool join_pass(void)
+{
+    uint32_t now = eventOS_event_timer_ticks();
+    bool pass;
+
+    platform_enter_critical();
+    pass = !join_passed ||
+           eventOS_event_timer_ticks_to_ms(now - join_pass_ticks) >= MBED_CONF_APP_MEMORY_PRESSURE_JOIN_INTERVAL_MS;
+    if (pass) {
+        join_pass_ticks = now;
+        join_passed = true;
+    } else {
+        stats.joins_dropped++;
+    }
+    platform_exit_critical();
+    return pass;
+}
+
+static int8_t join_gate_rx(const uint8_t *data_ptr, uint16_t data_len, uint8_t link_quality, int8_t dbm, int8_t driver_id)
+{
+    arm_net_phy_rx_fn *rx_cb = NULL;
+
+    for (uint8_t i = 0; i < join_gate_count; i++) {
+        if (join_gates[i].driver_id == driver_id) {
+            rx_cb = join_gates[i].rx_cb;
+        }
+    }
+    if (!rx_cb) {
+        return -1;
+    }
+
+    if ((stats.active & MEMORY_PRESSURE_JOINS) && join_request(data_ptr, data_len) && !join_pass()) {
+        return 0;
+    }
+    return rx_cb(data_ptr, data_len, link_quality, dbm, driver_id);
+}
+
+void memory_pressure_start(memory_pressure_action_cb *action_cb)
+{
+    if (!MBED_CONF_APP_MEMORY_PRESSURE || pressure_tasklet_id >= 0) {
+        return;
+    }
+
+    const mem_stat_t *heap_info = ns_dyn_mem_get_mem_stat();
+    if (!heap_info || !heap_info->heap_sector_size) {
+        tr_warn("Memory pressure monitor needs mbed-mesh-api.heap-stat-info");
+        return;
+    }
+
+    mode_action_cb = action_cb;
+    alloc_fails_prev = heap_info->heap_alloc_fail_cnt;
+    pressure_tasklet_id = eventOS_event_handler_create(&pressure_tasklet, ARM_LIB_TASKLET_INIT_EVENT);
+    tr_info("Memory pressure watermarks: dumps %u%%, joins %u%%, downlink %u%%, lifetimes %u%%",
+            MBED_CONF_APP_MEMORY_PRESSURE_DUMPS_WATERMARK, MBED_CONF_APP_MEMORY_PRESSURE_JOINS_WATERMARK,
+            MBED_CONF_APP_MEMORY_PRESSURE_DOWNLINK_WATERMARK, MBED_CONF_APP_MEMORY_PRESSURE_LIFETIME_WATERMARK);
+}
+
+bool memory_pressure_active(uint8_t action)
+{
+    return (stats.active & action) != 0;
+}
+
+void memory_pressure_join_gate(int8_t driver_id)
+{
+    phy_device_driver_s *driver;
+
+    if (!MBED_CONF_APP_MEMORY_PRESSURE || join_gate_count >= JOIN_GATE_MAX) {
+        return;
+    }
+
+    driver = arm_net_phy_driver_pointer(driver_id);
+    if (!driver || !driver->phy_rx_cb) {
+        return;
+    }
+
+    join_gates[join_gate_count].driver_id = driver_id;
+    join_gates[join_gate_count].rx_cb = driver->phy_rx_cb;
+    join_gate_count++;
+    driver->phy_rx_cb = &join_gate_rx;
+}
+
+int8_t memory_pressure_downlink_start(int8_t interface_id)
+{
+    if (!MBED_CONF_APP_MEMORY_PRESSURE) {
+        return 0;
+    }
+    return memory_pressure_downlink_set(interface_id, memory_pressure_active(MEMORY_PRESSURE_DOWNLINK));
+}
+
+int8_t memory_pressure_downlink_set(int8_t interface_id, bool capped)
+{
+    if (capped) {
+        return arm_nwk_sleepy_device_parent_buffer_size_set(interface_id, MBED_CONF_APP_INDIRECT_BIG_PACKET_THRESHOLD,
+                                                            1, MBED_CONF_APP_MEMORY_PRESSURE_DOWNLINK_FRAMES);
+    }
+    return arm_nwk_sleepy_device_parent_buffer_size_set(interface_id, MBED_CONF_APP_INDIRECT_BIG_PACKET_THRESHOLD,
+                                                        MBED_CONF_APP_INDIRECT_SMALL_PACKETS_PER_CHILD,
+                                                        MBED_CONF_APP_INDIRECT_BIG_PACKETS_TOTAL);
+}
+
+const memory_pressure_stats_t *memory_pressure_stats_get(void)
+{
+    return &stats;
+}
+
+void memory_pressure_print(void)
+{
+    if (pressure_tasklet_id < 0) {
+        return;
+    }
+    tr_info("Memory pressure: heap %u%% in use, max %u%%, actions 0x%02x, taken %lu times, joins dropped %lu",
+            stats.heap_percent, stats.heap_percent_max, stats.active,
+            (unsigned long)stats.activations, (unsigned long)stats.joins_dropped);
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#ifndef MEMORY_PRESSURE_H
+#define MEMORY_PRESSURE_H
+
+#include "ns_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Load shedding actions, each taken at its own heap watermark */
+#define MEMORY_PRESSURE_DUMPS       0x01    /**< Debug dumps suspended */
+#define MEMORY_PRESSURE_JOINS       0x02    /**< New nodes throttled */
+#define MEMORY_PRESSURE_DOWNLINK    0x04    /**< Queued downlink frames capped */
+#define MEMORY_PRESSURE_LIFETIME    0x08    /**< RPL DAO route lifetimes shortened */
+
+#ifndef MBED_CONF_APP_MEMORY_PRESSURE_LIFETIME_SCALE
+#define MBED_CONF_APP_MEMORY_PRESSURE_LIFETIME_SCALE 25
+#endif
+
+/* A lifetime cut to "memory-pressure-lifetime-scale" percent, at least 1 */
+#define MEMORY_PRESSURE_LIFETIME_SHORTENED(lifetime) \
+    ((lifetime) * MBED_CONF_APP_MEMORY_PRESSURE_LIFETIME_SCALE >= 100 ? \
+     (lifetime) * MBED_CONF_APP_MEMORY_PRESSURE_LIFETIME_SCALE / 100 : 1)
+
+typedef struct memory_pressure_stats {
+    uint8_t active;                 /**< MEMORY_PRESSURE_* actions in effect */
+    uint8_t heap_percent;           /**< Heap in use at the last poll */
+    uint8_t heap_percent_max;       /**< Highest heap_percent seen */
+    uint32_t activations;           /**< Actions taken so far */
+    uint32_t joins_dropped;         /**< Join requests dropped by the join gate */
+} memory_pressure_stats_t;
+
+/**
+ * Takes or releases a mesh mode specific action. Called on the event loop.
+ *
+ * \param action MEMORY_PRESSURE_JOINS, MEMORY_PRESSURE_DOWNLINK or MEMORY_PRESSURE_LIFETIME
+ * \param active true to shed the load, false to return to normal
+ * \return true if the mesh mode supports the action
+ */
+typedef bool memory_pressure_action_cb(uint8_t action, bool active);
+
+/**
+ * Starts polling the nanostack heap. Does nothing unless "memory-pressure"
+ * is set and heap statistics are enabled.
+ */
+void memory_pressure_start(memory_pressure_action_cb *action_cb);
+
+/**
+ * Returns true while the given action is in effect.
+ */
+bool memory_pressure_active(uint8_t action);
+
+/**
+ * Throttles join requests received by a PHY driver while MEMORY_PRESSURE_JOINS
+ * is in effect. 802.15.4 beacon requests and Wi-SUN PAN Advertisement
+ * Solicits pass at most once every "memory-pressure-join-interval-ms", nodes
+ * already in the network are not affected. Call after the MAC has been
+ * created on the driver and before packet_capture_tap(), so that the capture
+ * still shows the dropped requests.
+ */
+void memory_pressure_join_gate(int8_t driver_id);
+
+/**
+ * Sets the indirect queues of sleepy children to the "indirect-*" sizes, or
+ * to the capped sizes while MEMORY_PRESSURE_DOWNLINK is in effect. Call
+ * before the mesh interface is brought up, so that the sizes a released cap
+ * returns to are the ones that were in effect. Does nothing unless
+ * "memory-pressure" is set.
+ *
+ * \return 0 on success, <0 on errors
+ */
+int8_t memory_pressure_downlink_start(int8_t interface_id);
+
+/**
+ * Sets the indirect queues of sleepy children to the capped sizes, or back
+ * to the "indirect-*" sizes applied by memory_pressure_downlink_start().
+ *
+ * \return 0 on success, <0 on errors
+ */
+int8_t memory_pressure_downlink_set(int8_t interface_id, bool capped);
+
+/**
+ * Returns the shedding state and counters.
+ */
+const memory_pressure_stats_t *memory_pressure_stats_get(void);
+
+/**
+ * Prints the shedding state and counters.
+ */
+void memory_pressure_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEMORY_PRESSURE_H */
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#include <string.h>
+#include "ns_types.h"
+#include "eventOS_event.h"
+#include "eventOS_event_timer.h"
+#include "net_interface.h"
+#include "nsdynmemLIB.h"
+#include "mesh_scale_report.h"
+
+#define LOWPAN_ND 0
+#define THREAD 1
+#define LOWPAN_WS 2
+
+#if MBED_CONF_APP_MESH_MODE == THREAD
+#include "thread_test_api.h"
+#elif MBED_CONF_APP_MESH_MODE == LOWPAN_WS
+#include "ws_bbr_api.h"
+#else
+#include "whiteboard_api.h"
+#endif
+
+#include "ns_trace.h"
+#define TRACE_GROUP "scal"
+
+#ifndef MBED_CONF_APP_SCALE_REPORT_NODES
+#define MBED_CONF_APP_SCALE_REPORT_NODES 0
+#endif
+
+#define SCALE_REPORT_TIMER 1
+#define SCALE_REPORT_POLL_MS 1000
+
+static mesh_scale_report_t report;
+static uint32_t start_ticks;
+static int8_t scale_report_tasklet_id = -1;
+static int8_t mesh_interface_id = -1;
+static bool mesh_ready;
+
+static uint32_t elapsed_ms(void)
+{
+    return eventOS_event_timer_ticks_to_ms(eventOS_event_timer_ticks() - start_ticks);
+}
+
+static void scale_report_poll(void)
+{
+    const mem_stat_t *heap_info = ns_dyn_mem_get_mem_stat();
+
+    if (heap_info && heap_info->heap_sector_allocated_bytes_max > report.heap_allocated_max) {
+        report.heap_allocated_max = heap_info->heap_sector_allocated_bytes_max;
+    }
+
+    if (mesh_ready) {
+        report.registered_nodes = mesh_registered_node_count(mesh_interface_id);
+    }
+
+    if (report.registration_ms == 0 && report.registered_nodes >= report.expected_nodes) {
+        report.registration_ms = elapsed_ms();
+        tr_info("Scale report: nodes %u, bootstrap %lu ms, registration %lu ms, heap max %lu",
+                report.registered_nodes,
+                (unsigned long)report.bootstrap_ms,
+                (unsigned long)report.registration_ms,
+                (unsigned long)report.heap_allocated_max);
+    }
+}
+
+static void scale_report_tasklet(arm_event_s *event)
+{
+    switch (event->event_type) {
+        case ARM_LIB_TASKLET_INIT_EVENT:
+            scale_report_tasklet_id = event->receiver;
+            eventOS_event_timer_request(SCALE_REPORT_TIMER, ARM_LIB_SYSTEM_TIMER_EVENT,
+                                        scale_report_tasklet_id, SCALE_REPORT_POLL_MS);
+            break;
+
+        case ARM_LIB_SYSTEM_TIMER_EVENT:
+            if (event->event_id == SCALE_REPORT_TIMER) {
+                scale_report_poll();
+                /* Keep tracking node count and peak heap after the report is complete */
+                eventOS_event_timer_request(SCALE_REPORT_TIMER, ARM_LIB_SYSTEM_TIMER_EVENT,
+                                            scale_report_tasklet_id, SCALE_REPORT_POLL_MS);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void mesh_scale_report_start(void)
+{
+    if (MBED_CONF_APP_SCALE_REPORT_NODES == 0 || scale_report_tasklet_id >= 0) {
+        return;
+    }
+
+    memset(&report, 0, sizeof(report));
+    report.expected_nodes = MBED_CONF_APP_SCALE_REPORT_NODES;
+    start_ticks = eventOS_event_timer_ticks();
+
+    eventOS_event_handler_create(&scale_report_tasklet, ARM_LIB_TASKLET_INIT_EVENT);
+}
+
+void mesh_scale_report_bootstrap_done(int8_t interface_id)
+{
+    if (scale_report_tasklet_id < 0 || mesh_ready) {
+        return;
+    }
+    mesh_interface_id = interface_id;
+    mesh_ready = true;
+    report.bootstrap_ms = elapsed_ms();
+    tr_info("Scale report: bootstrap complete in %lu ms", (unsigned long)report.bootstrap_ms);
+}
+
+const mesh_scale_report_t *mesh_scale_report_get(void)
+{
+    return &report;
+}
+
+uint16_t mesh_registered_node_count(int8_t interface_id)
+{
+#if MBED_CONF_APP_MESH_MODE == THREAD
+    int count = thread_test_child_count_get(interface_id);
+
+    return count > 0 ? count : 0;
+#elif MBED_CONF_APP_MESH_MODE == LOWPAN_WS
+    bbr_information_t info;
+
+    if (ws_bbr_info_get(interface_id, &info) != 0) {
+        return 0;
+    }
+    return info.devices_in_network;
+#else
+    /* Every node registers its global address with the 6LBR, which keeps it in the whiteboard.
+     * A node holds an entry per registered address, for example the old and the new prefix
+     * during a prefix change, so count each EUI-64 once. */
+    uint16_t count = 0;
+    whiteboard_entry_t *entry = NULL;
+
+    while ((entry = whiteboard_get(entry)) != NULL) {
+        if (entry->interface_index != interface_id) {
+            continue;
+        }
+
+        whiteboard_entry_t *earlier = NULL;
+        while ((earlier = whiteboard_get(earlier)) != entry) {
+            if (earlier->interface_index == interface_id && memcmp(earlier->eui64, entry->eui64, 8) == 0) {
+                break;
+            }
+        }
+        if (earlier == entry) {
+            count++;
+        }
+    }
+    return count;
+#endif
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#ifndef MESH_SCALE_REPORT_H
+#define MESH_SCALE_REPORT_H
+
+#include "ns_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct mesh_scale_report {
+    uint16_t expected_nodes;        /**< Node count that completes the report */
+    uint16_t registered_nodes;      /**< Nodes with a route registered at the border router */
+    uint32_t bootstrap_ms;          /**< Tasklet start to "Bootstrap Complete" */
+    uint32_t registration_ms;       /**< Tasklet start to all expected nodes registered, 0 if pending */
+    uint32_t heap_allocated_max;    /**< Peak heap_sector_allocated_bytes_max seen so far */
+} mesh_scale_report_t;
+
+/**
+ * Starts collecting the scaling report. Does nothing unless
+ * "scale-report-nodes" is configured.
+ */
+void mesh_scale_report_start(void);
+
+/**
+ * Marks the mesh interface bootstrap complete.
+ *
+ * \param interface_id Mesh interface the nodes register with
+ */
+void mesh_scale_report_bootstrap_done(int8_t interface_id);
+
+/**
+ * Returns the report collected so far.
+ */
+const mesh_scale_report_t *mesh_scale_report_get(void);
+
+/**
+ * Counts the nodes registered at the border router: 6LoWPAN ND nodes with
+ * addresses registered at the 6LBR, Wi-SUN DAO targets or attached Thread
+ * children. A 6LoWPAN ND node with several registered addresses counts once.
+ *
+ * \param interface_id Mesh interface
+ */
+uint16_t mesh_registered_node_count(int8_t interface_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MESH_SCALE_REPORT_H */
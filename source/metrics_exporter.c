@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#include <string.h>
+#include "ns_types.h"
+#include "common_functions.h"
+#include "eventOS_event.h"
+#include "eventOS_event_timer.h"
+#include "socket_api.h"
+#include "net_interface.h"
+#include "nsdynmemLIB.h"
+#include "ip6string.h"
+#include "metrics_exporter.h"
+
+#include "ns_trace.h"
+#define TRACE_GROUP "metr"
+
+#ifndef MBED_CONF_APP_METRICS_PORT
+#define MBED_CONF_APP_METRICS_PORT 0
+#endif
+
+#ifndef MBED_CONF_APP_METRICS_DESTINATION
+#define MBED_CONF_APP_METRICS_DESTINATION "ff02::1"
+#endif
+
+#ifndef MBED_CONF_APP_METRICS_INTERVAL_MS
+#define MBED_CONF_APP_METRICS_INTERVAL_MS 10000
+#endif
+
+#define METRICS_TIMER 1
+#define RECORD_VERSION 1
+
+static const nwk_stats_t *nwk_stats;
+static int8_t metrics_tasklet_id = -1;
+static int8_t metrics_socket = -1;
+static int8_t backhaul_interface_id = -1;
+static int8_t mesh_interface_ids[METRICS_MESH_MAX];
+static uint8_t mesh_interface_count;
+static uint16_t sequence;
+static ns_address_t destination;
+
+static uint8_t interface_state(int8_t interface_id)
+{
+    uint8_t address[16];
+    uint8_t state = METRICS_IF_PRESENT;
+
+    if (arm_net_address_get(interface_id, ADDR_IPV6_LL, address) == 0) {
+        state |= METRICS_IF_LINK_LOCAL;
+    }
+    if (arm_net_address_get(interface_id, ADDR_IPV6_GP, address) == 0) {
+        state |= METRICS_IF_GLOBAL;
+    }
+    return state;
+}
+
+uint16_t metrics_exporter_record_build(uint8_t *record)
+{
+    const mem_stat_t *heap_info = ns_dyn_mem_get_mem_stat();
+    uint8_t *ptr = record;
+
+    memset(record, 0, METRICS_RECORD_LEN);
+    memcpy(ptr, "BRMX", 4);
+    ptr += 4;
+    *ptr++ = RECORD_VERSION;
+    *ptr++ = MBED_CONF_APP_MESH_MODE;
+    ptr = common_write_16_bit(sequence, ptr);
+    ptr = common_write_32_bit(eventOS_event_timer_ticks_to_ms(eventOS_event_timer_ticks()) / 1000, ptr);
+
+    if (heap_info) {
+        ptr = common_write_32_bit(heap_info->heap_sector_size, ptr);
+        ptr = common_write_32_bit(heap_info->heap_sector_allocated_bytes, ptr);
+        ptr = common_write_32_bit(heap_info->heap_sector_allocated_bytes_max, ptr);
+        ptr = common_write_32_bit(heap_info->heap_alloc_fail_cnt, ptr);
+    } else {
+        ptr += 16;
+    }
+
+    *ptr++ = backhaul_interface_id >= 0 ? interface_state(backhaul_interface_id) : 0;
+    *ptr++ = mesh_interface_count;
+    for (uint8_t i = 0; i < METRICS_MESH_MAX; i++) {
+        *ptr++ = i < mesh_interface_count ? interface_state(mesh_interface_ids[i]) : 0;
+    }
+
+    if (nwk_stats) {
+        ptr = common_write_32_bit(nwk_stats->ip_rx_count, ptr);
+        ptr = common_write_32_bit(nwk_stats->ip_tx_count, ptr);
+        ptr = common_write_32_bit(nwk_stats->ip_rx_drop, ptr);
+        ptr = common_write_32_bit(nwk_stats->ip_cksum_error, ptr);
+        ptr = common_write_32_bit(nwk_stats->ip_tx_bytes, ptr);
+        ptr = common_write_32_bit(nwk_stats->ip_rx_bytes, ptr);
+        ptr = common_write_32_bit(nwk_stats->ip_routed_up, ptr);
+        ptr = common_write_32_bit(nwk_stats->ip_no_route, ptr);
+        ptr = common_write_32_bit(nwk_stats->frag_rx_errors, ptr);
+        ptr = common_write_32_bit(nwk_stats->frag_tx_errors, ptr);
+        ptr = common_write_32_bit(nwk_stats->rpl_total_memory, ptr);
+        ptr = common_write_16_bit(nwk_stats->ip_routeloop_detect, ptr);
+        ptr = common_write_16_bit(nwk_stats->rpl_memory_overflow, ptr);
+        ptr = common_write_16_bit(nwk_stats->rpl_parent_tx_fail, ptr);
+        ptr = common_write_16_bit(nwk_stats->rpl_unknown_instance, ptr);
+        ptr = common_write_16_bit(nwk_stats->rpl_local_repair, ptr);
+        ptr = common_write_16_bit(nwk_stats->rpl_global_repair, ptr);
+        ptr = common_write_16_bit(nwk_stats->rpl_malformed_message, ptr);
+        ptr = common_write_16_bit(nwk_stats->rpl_time_no_next_hop, ptr);
+        ptr = common_write_16_bit(nwk_stats->buf_alloc, ptr);
+        ptr = common_write_16_bit(nwk_stats->buf_headroom_realloc, ptr);
+        ptr = common_write_16_bit(nwk_stats->buf_headroom_shuffle, ptr);
+        common_write_16_bit(nwk_stats->buf_headroom_fail, ptr);
+    }
+
+    return METRICS_RECORD_LEN;
+}
+
+static void metrics_send(void)
+{
+    uint8_t record[METRICS_RECORD_LEN];
+    uint16_t len;
+
+    if (metrics_socket < 0) {
+        return;
+    }
+
+    len = metrics_exporter_record_build(record);
+    /* Queued by the stack, a full queue drops this record and the next one follows */
+    if (socket_sendto(metrics_socket, &destination, record, len) == 0) {
+        sequence++;
+    }
+}
+
+static void metrics_socket_cb(void *cb)
+{
+    (void) cb;
+}
+
+static void metrics_tasklet(arm_event_s *event)
+{
+    switch (event->event_type) {
+        case ARM_LIB_TASKLET_INIT_EVENT:
+            metrics_tasklet_id = event->receiver;
+            eventOS_event_timer_request(METRICS_TIMER, ARM_LIB_SYSTEM_TIMER_EVENT,
+                                        metrics_tasklet_id, MBED_CONF_APP_METRICS_INTERVAL_MS);
+            break;
+
+        case ARM_LIB_SYSTEM_TIMER_EVENT:
+            if (event->event_id == METRICS_TIMER) {
+                metrics_send();
+                eventOS_event_timer_request(METRICS_TIMER, ARM_LIB_SYSTEM_TIMER_EVENT,
+                                            metrics_tasklet_id, MBED_CONF_APP_METRICS_INTERVAL_MS);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void metrics_exporter_start(const nwk_stats_t *stats)
+{
+    if (MBED_CONF_APP_METRICS_PORT == 0 || metrics_tasklet_id >= 0) {
+        return;
+    }
+
+    nwk_stats = stats;
+    memset(&destination, 0, sizeof(destination));
+    destination.type = ADDRESS_IPV6;
+    destination.identifier = MBED_CONF_APP_METRICS_PORT;
+    if (!stoip6(MBED_CONF_APP_METRICS_DESTINATION, strlen(MBED_CONF_APP_METRICS_DESTINATION), destination.address)) {
+        tr_error("Invalid metrics destination %s", MBED_CONF_APP_METRICS_DESTINATION);
+        return;
+    }
+
+    eventOS_event_handler_create(&metrics_tasklet, ARM_LIB_TASKLET_INIT_EVENT);
+}
+
+void metrics_exporter_backhaul_ready(int8_t backhaul_if_id)
+{
+    backhaul_interface_id = backhaul_if_id;
+
+    if (MBED_CONF_APP_METRICS_PORT == 0 || metrics_tasklet_id < 0) {
+        return;
+    }
+
+    if (metrics_socket < 0) {
+        metrics_socket = socket_open(SOCKET_UDP, 0, metrics_socket_cb);
+        if (metrics_socket < 0) {
+            tr_error("Metrics socket open failed");
+            return;
+        }
+    }
+
+    socket_setsockopt(metrics_socket, SOCKET_IPPROTO_IPV6, SOCKET_INTERFACE_SELECT,
+                      &backhaul_interface_id, sizeof(backhaul_interface_id));
+    tr_info("Metrics to [%s]:%d every %d ms", MBED_CONF_APP_METRICS_DESTINATION,
+            MBED_CONF_APP_METRICS_PORT, MBED_CONF_APP_METRICS_INTERVAL_MS);
+}
+
+void metrics_exporter_mesh_ready(int8_t mesh_if_id)
+{
+    for (uint8_t i = 0; i < mesh_interface_count; i++) {
+        if (mesh_interface_ids[i] == mesh_if_id) {
+            return;
+        }
+    }
+    if (mesh_interface_count < METRICS_MESH_MAX) {
+        mesh_interface_ids[mesh_interface_count++] = mesh_if_id;
+    }
+}
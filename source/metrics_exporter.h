@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include "ns_types.h"
+#include "nwk_stats_api.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+ * Metrics record, big-endian:
+ *
+ *   0  magic "BRMX"                        4
+ *   4  version (1)                         1
+ *   5  mesh mode                           1   MBED_CONF_APP_MESH_MODE
+ *   6  sequence                            2
+ *   8  uptime, seconds                     4
+ *  12  heap_sector_size                    4
+ *  16  heap_sector_allocated_bytes         4
+ *  20  heap_sector_allocated_bytes_max     4
+ *  24  heap_alloc_fail_cnt                 4
+ *  28  backhaul state                      1   METRICS_IF_* flags
+ *  29  mesh interface count                1
+ *  30  mesh states                         4   METRICS_IF_* flags per mesh interface
+ *  34  ip_rx_count                         4
+ *  38  ip_tx_count                         4
+ *  42  ip_rx_drop                          4
+ *  46  ip_cksum_error                      4
+ *  50  ip_tx_bytes                         4
+ *  54  ip_rx_bytes                         4
+ *  58  ip_routed_up                        4
+ *  62  ip_no_route                         4
+ *  66  frag_rx_errors                      4
+ *  70  frag_tx_errors                      4
+ *  74  rpl_total_memory                    4
+ *  78  ip_routeloop_detect                 2
+ *  80  rpl_memory_overflow                 2
+ *  82  rpl_parent_tx_fail                  2
+ *  84  rpl_unknown_instance                2
+ *  86  rpl_local_repair                    2
+ *  88  rpl_global_repair                   2
+ *  90  rpl_malformed_message               2
+ *  92  rpl_time_no_next_hop                2
+ *  94  buf_alloc                           2
+ *  96  buf_headroom_realloc                2
+ *  98  buf_headroom_shuffle                2
+ * 100  buf_headroom_fail                   2
+ */
+#define METRICS_RECORD_LEN 102
+#define METRICS_MESH_MAX 4
+
+/* Interface state flags */
+#define METRICS_IF_PRESENT      0x01
+#define METRICS_IF_LINK_LOCAL   0x02
+#define METRICS_IF_GLOBAL       0x04
+
+/**
+ * Starts the exporter on the statistics the tasklet collects. Does nothing
+ * unless "metrics-port" is set.
+ */
+void metrics_exporter_start(const nwk_stats_t *stats);
+
+/**
+ * Sends the records on the backhaul interface from now on.
+ */
+void metrics_exporter_backhaul_ready(int8_t backhaul_if_id);
+
+/**
+ * Adds a mesh interface to the interface state of the record.
+ */
+void metrics_exporter_mesh_ready(int8_t mesh_if_id);
+
+/**
+ * Fills a record with the current values.
+ *
+ * \return METRICS_RECORD_LEN
+ */
+uint16_t metrics_exporter_record_build(uint8_t *record);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* METRICS_EXPORTER_H */
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#include <string.h>
+#include "ns_types.h"
+#include "multicast_api.h"
+#include "borderrouter_helpers.h"
+#include "mld_proxy.h"
+
+#include "ns_trace.h"
+#define TRACE_GROUP "mldp"
+
+#ifndef MBED_CONF_APP_BACKHAUL_MLD
+#define MBED_CONF_APP_BACKHAUL_MLD false
+#endif
+
+#ifndef MBED_CONF_APP_BACKHAUL_MLD_MAX_GROUPS
+#define MBED_CONF_APP_BACKHAUL_MLD_MAX_GROUPS 16
+#endif
+
+#if MBED_CONF_APP_BACKHAUL_MLD_MAX_GROUPS < 1 || MBED_CONF_APP_BACKHAUL_MLD_MAX_GROUPS > 255
+#error "backhaul-mld-max-groups must be 1-255"
+#endif
+
+/* Groups are kept sorted so lookups are a binary search over 16-byte keys */
+static uint8_t groups[MBED_CONF_APP_BACKHAUL_MLD_MAX_GROUPS][16];
+static uint8_t group_count;
+static int8_t mesh_interface_id = -1;
+
+/* Index of the group, or the bitwise complement of its insertion point */
+static int group_find(const uint8_t group[16])
+{
+    int low = 0;
+    int high = group_count - 1;
+
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        int cmp = memcmp(groups[mid], group, 16);
+        if (cmp == 0) {
+            return mid;
+        }
+        if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return ~low;
+}
+
+static void group_install(const uint8_t group[16])
+{
+    if (multicast_fwd_add(mesh_interface_id, group, 0xffffffff) != 0) {
+        tr_warn("Group %s not added to interface %d", tr_ipv6(group), mesh_interface_id);
+    }
+}
+
+void mld_proxy_backhaul_ready(int8_t backhaul_if_id)
+{
+    if (!MBED_CONF_APP_BACKHAUL_MLD) {
+        return;
+    }
+
+    if (multicast_fwd_set_proxy_upstream(backhaul_if_id) != 0) {
+        tr_error("MLD proxy upstream failed");
+        return;
+    }
+    tr_info("MLD proxy upstream: interface %d", backhaul_if_id);
+}
+
+void mld_proxy_mesh_ready(int8_t mesh_if_id)
+{
+    if (!MBED_CONF_APP_BACKHAUL_MLD) {
+        return;
+    }
+
+    mesh_interface_id = mesh_if_id;
+    multicast_fwd_set_forwarding(mesh_if_id, true);
+
+    /* The interface may have been restarted, install the groups again */
+    for (uint8_t i = 0; i < group_count; i++) {
+        group_install(groups[i]);
+    }
+    tr_info("MLD proxy downstream: interface %d, %u groups", mesh_if_id, group_count);
+}
+
+int mld_proxy_subscribe(const uint8_t group[16])
+{
+    int index;
+
+    if (group[0] != 0xff) {
+        return -1;
+    }
+
+    index = group_find(group);
+    if (index >= 0) {
+        return 0;
+    }
+
+    index = ~index;
+    if (group_count == MBED_CONF_APP_BACKHAUL_MLD_MAX_GROUPS) {
+        tr_warn("MLD proxy table full, %s dropped", tr_ipv6(group));
+        return -1;
+    }
+    memmove(groups[index + 1], groups[index], (group_count - index) * sizeof(groups[0]));
+    memcpy(groups[index], group, 16);
+    group_count++;
+
+    if (MBED_CONF_APP_BACKHAUL_MLD && mesh_interface_id >= 0) {
+        group_install(group);
+    }
+    return 0;
+}
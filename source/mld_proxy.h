@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#ifndef MLD_PROXY_H
+#define MLD_PROXY_H
+
+#include "ns_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Makes the backhaul the MLD proxy upstream. Does nothing unless
+ * "backhaul-mld" is enabled.
+ */
+void mld_proxy_backhaul_ready(int8_t backhaul_if_id);
+
+/**
+ * Enables multicast forwarding on the mesh interface and installs the
+ * subscription table on it.
+ */
+void mld_proxy_mesh_ready(int8_t mesh_if_id);
+
+/**
+ * Adds a group listened to in the mesh. The group is reported on the
+ * backhaul for as long as the border router runs.
+ *
+ * Listeners that mesh nodes register themselves are learnt and reported
+ * by the Nanostack MLD proxy on the forwarding interfaces, and are not kept
+ * in this table. Subscribe here the groups the border router listens to on
+ * behalf of the mesh, for example the configured multicast groups, so that
+ * they are reported even before a node registers.
+ *
+ * \return 0 on success, -1 if the table is full or the group is not multicast
+ */
+int mld_proxy_subscribe(const uint8_t group[16]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MLD_PROXY_H */
@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#include <string.h>
+#include "ns_types.h"
+#include "eventOS_event_timer.h"
+#include "multicast_api.h"
+#include "socket_api.h"
+#include "ip6string.h"
+#include "borderrouter_helpers.h"
+#include "multicast_groups.h"
+
+#include "ns_trace.h"
+#define TRACE_GROUP "mcgr"
+
+#ifndef MBED_CONF_APP_MULTICAST_MAX_GROUPS
+#define MBED_CONF_APP_MULTICAST_MAX_GROUPS 32
+#endif
+
+/* Datagrams remembered for repeat detection */
+#define RECENT_DATAGRAMS 16
+
+#define GROUP_SOCKETS_MAX 4
+
+typedef struct {
+    uint8_t address[16];
+    const multicast_group_config_t *config;
+    multicast_group_stats_t stats;
+} multicast_group_t;
+
+typedef struct {
+    uint32_t hash;
+    uint32_t seen_ticks;
+    uint8_t group;
+    bool valid;
+} recent_datagram_t;
+
+/* Matches the parameters given to multicast_set_parameters() before groups were configurable */
+static const multicast_group_config_t default_config = {
+    .address = NULL,
+    .port = 0,
+    .imin_ms = 500,
+    .imax_ms = 500,
+    .k = 20,
+    .timer_expirations = 3,
+    .seed_lifetime_s = 4
+};
+
+#ifdef MBED_CONF_APP_MULTICAST_GROUPS
+static const multicast_group_config_t group_config[] = MBED_CONF_APP_MULTICAST_GROUPS;
+#endif
+
+/* Sorted by address so that received datagrams find their group with a binary search */
+static multicast_group_t groups[MBED_CONF_APP_MULTICAST_MAX_GROUPS];
+static uint8_t group_count;
+
+static recent_datagram_t recent[RECENT_DATAGRAMS];
+static uint8_t recent_next;
+
+/* One socket per UDP port, shared by the groups on that port */
+static int8_t group_sockets[GROUP_SOCKETS_MAX];
+static uint16_t group_socket_ports[GROUP_SOCKETS_MAX];
+static uint8_t group_socket_count;
+
+static multicast_group_t *group_find(const uint8_t address[16])
+{
+    int low = 0;
+    int high = group_count - 1;
+
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        int cmp = memcmp(groups[mid].address, address, 16);
+        if (cmp == 0) {
+            return &groups[mid];
+        }
+        if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return NULL;
+}
+
+static void group_insert(const uint8_t address[16], const multicast_group_config_t *config)
+{
+    uint8_t i;
+
+    if (group_count == MBED_CONF_APP_MULTICAST_MAX_GROUPS) {
+        tr_error("Too many multicast groups, %s ignored", tr_ipv6(address));
+        return;
+    }
+    if (group_find(address)) {
+        tr_warn("Multicast group %s configured twice", tr_ipv6(address));
+        return;
+    }
+
+    for (i = group_count; i > 0 && memcmp(groups[i - 1].address, address, 16) > 0; i--) {
+        groups[i] = groups[i - 1];
+    }
+    memset(&groups[i], 0, sizeof(groups[i]));
+    memcpy(groups[i].address, address, 16);
+    groups[i].config = config;
+    group_count++;
+}
+
+/* FNV-1a over the source address and the payload */
+static uint32_t datagram_hash(const uint8_t *src, const uint8_t *data, uint16_t len)
+{
+    uint32_t hash = 2166136261u;
+
+    for (uint8_t i = 0; i < 16; i++) {
+        hash = (hash ^ src[i]) * 16777619u;
+    }
+    for (uint16_t i = 0; i < len; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void datagram_count(multicast_group_t *group, uint32_t hash)
+{
+    uint8_t index = group - groups;
+    uint32_t now = eventOS_event_timer_ticks();
+    uint32_t seed_lifetime = group->config->seed_lifetime_s * eventOS_event_timer_ms_to_ticks(1000);
+
+    for (uint8_t i = 0; i < RECENT_DATAGRAMS; i++) {
+        if (recent[i].valid && recent[i].group == index && recent[i].hash == hash &&
+                now - recent[i].seen_ticks <= seed_lifetime) {
+            group->stats.repeated++;
+            return;
+        }
+    }
+
+    group->stats.received++;
+    recent[recent_next].hash = hash;
+    recent[recent_next].seen_ticks = now;
+    recent[recent_next].group = index;
+    recent[recent_next].valid = true;
+    recent_next = (recent_next + 1) % RECENT_DATAGRAMS;
+}
+
+static void group_socket_cb(void *cb)
+{
+    socket_callback_t *sock_cb = (socket_callback_t *) cb;
+    uint8_t buf[256];
+    uint8_t ancillary[NS_CMSG_SPACE(sizeof(ns_in6_pktinfo_t))];
+    ns_address_t src;
+    ns_iovec_t iov = { buf, sizeof(buf) };
+    ns_msghdr_t msg = {
+        .msg_name = &src,
+        .msg_namelen = sizeof(src),
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = ancillary,
+        .msg_controllen = sizeof(ancillary),
+        .flags = 0
+    };
+    const uint8_t *dst = NULL;
+    int16_t len;
+
+    if ((sock_cb->event_type & SOCKET_EVENT_MASK) != SOCKET_DATA) {
+        return;
+    }
+
+    len = socket_recvmsg(sock_cb->socket_id, &msg, 0);
+    if (len < 0) {
+        return;
+    }
+
+    for (ns_cmsghdr_t *cmsg = NS_CMSG_FIRSTHDR(&msg); cmsg; cmsg = NS_CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOCKET_IPPROTO_IPV6 && cmsg->cmsg_type == SOCKET_IPV6_PKTINFO) {
+            dst = ((ns_in6_pktinfo_t *) NS_CMSG_DATA(cmsg))->ipi6_addr;
+        }
+    }
+
+    multicast_group_t *group = dst ? group_find(dst) : NULL;
+    if (group) {
+        datagram_count(group, datagram_hash(src.address, buf, len));
+    }
+}
+
+static int8_t group_socket_open(uint16_t port)
+{
+    static const bool enable = true;
+    int8_t sid;
+
+    for (uint8_t i = 0; i < group_socket_count; i++) {
+        if (group_socket_ports[i] == port) {
+            return group_sockets[i];
+        }
+    }
+
+    if (group_socket_count == GROUP_SOCKETS_MAX) {
+        tr_warn("No socket for multicast port %u", port);
+        return -1;
+    }
+
+    sid = socket_open(SOCKET_UDP, port, group_socket_cb);
+    if (sid < 0) {
+        tr_warn("Multicast port %u open failed", port);
+        return -1;
+    }
+    socket_setsockopt(sid, SOCKET_IPPROTO_IPV6, SOCKET_IPV6_RECVPKTINFO, &enable, sizeof(enable));
+    group_socket_ports[group_socket_count] = port;
+    group_sockets[group_socket_count++] = sid;
+    return sid;
+}
+
+static void group_listen(const multicast_group_t *group)
+{
+    ns_ipv6_mreq_t mreq;
+    int8_t sid;
+
+    if (!group->config->port) {
+        return;
+    }
+
+    sid = group_socket_open(group->config->port);
+    if (sid < 0) {
+        return;
+    }
+
+    memcpy(mreq.ipv6mr_multiaddr, group->address, 16);
+    mreq.ipv6mr_interface = 0;
+    if (socket_setsockopt(sid, SOCKET_IPPROTO_IPV6, SOCKET_IPV6_JOIN_GROUP, &mreq, sizeof(mreq)) != 0) {
+        tr_warn("Joining %s failed", tr_ipv6(group->address));
+    }
+}
+
+void multicast_groups_init(const uint8_t default_address[16])
+{
+    group_count = 0;
+
+#ifdef MBED_CONF_APP_MULTICAST_GROUPS
+    (void) default_address;
+    for (uint8_t i = 0; i < sizeof(group_config) / sizeof(group_config[0]); i++) {
+        uint8_t address[16];
+        const char *str = group_config[i].address;
+
+        if (!stoip6(str, strlen(str), address) || address[0] != 0xff) {
+            tr_error("Invalid multicast group \"%s\"", str);
+            continue;
+        }
+        /* MPL takes the seed set entry lifetime as 16 bits */
+        if (group_config[i].seed_lifetime_s > 0xffff) {
+            tr_error("Multicast group \"%s\" seed lifetime %lu s out of range", str,
+                     (unsigned long)group_config[i].seed_lifetime_s);
+            continue;
+        }
+        group_insert(address, &group_config[i]);
+    }
+#else
+    group_insert(default_address, &default_config);
+#endif
+
+    for (uint8_t i = 0; i < group_count; i++) {
+        group_listen(&groups[i]);
+    }
+    tr_info("Multicast groups: %u", group_count);
+}
+
+void multicast_groups_subscribe(int8_t interface_id)
+{
+    for (uint8_t i = 0; i < group_count; i++) {
+        const multicast_group_config_t *config = groups[i].config;
+        int8_t ret;
+
+        /* -1 keeps the default proactive forwarding */
+        ret = multicast_mpl_domain_subscribe_with_parameters(interface_id, groups[i].address,
+                                                             MULTICAST_MPL_SEED_ID_DEFAULT, -1,
+                                                             config->seed_lifetime_s,
+                                                             config->imin_ms, config->imax_ms,
+                                                             config->k, config->timer_expirations,
+                                                             config->imin_ms, config->imax_ms,
+                                                             config->k, config->timer_expirations);
+        if (ret != 0) {
+            tr_error("MPL domain %s subscribe failed, ret = %d", tr_ipv6(groups[i].address), ret);
+        }
+    }
+}
+
+uint8_t multicast_groups_count(void)
+{
+    return group_count;
+}
+
+const uint8_t *multicast_groups_address(uint8_t index)
+{
+    return index < group_count ? groups[index].address : NULL;
+}
+
+const multicast_group_stats_t *multicast_groups_stats(const uint8_t address[16])
+{
+    multicast_group_t *group = group_find(address);
+
+    return group ? &group->stats : NULL;
+}
+
+void multicast_groups_print(void)
+{
+    for (uint8_t i = 0; i < group_count; i++) {
+        tr_info_lazy("Multicast %s received: %lu, repeated: %lu", tr_ipv6(groups[i].address),
+                     (unsigned long)groups[i].stats.received, (unsigned long)groups[i].stats.repeated);
+    }
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#ifndef MULTICAST_GROUPS_H
+#define MULTICAST_GROUPS_H
+
+#include "ns_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** One entry of the "multicast-groups" configuration */
+typedef struct multicast_group_config {
+    const char *address;            /**< Group address, for example "ff05::7" */
+    uint16_t port;                  /**< UDP port counted at the border router, 0 for none */
+    uint16_t imin_ms;               /**< MPL data message Trickle Imin */
+    uint16_t imax_ms;               /**< MPL data message Trickle Imax */
+    uint8_t k;                      /**< MPL data message Trickle redundancy constant */
+    uint8_t timer_expirations;      /**< Trickle expirations before a message is no longer forwarded */
+    uint32_t seed_lifetime_s;       /**< MPL seed set entry lifetime, at most 65535 */
+} multicast_group_config_t;
+
+/** Datagrams delivered to the border router on the group port, not MPL forwarding counts */
+typedef struct multicast_group_stats {
+    uint32_t received;              /**< Datagrams received on the group */
+    uint32_t repeated;              /**< Same payload from the same source again within the seed lifetime */
+} multicast_group_stats_t;
+
+/**
+ * Loads the group table from "multicast-groups", or a single group with
+ * default parameters when the option is not set.
+ *
+ * \param default_address Group used when "multicast-groups" is not set
+ */
+void multicast_groups_init(const uint8_t default_address[16]);
+
+/**
+ * Subscribes an interface to the MPL domain of every configured group.
+ */
+void multicast_groups_subscribe(int8_t interface_id);
+
+/**
+ * Returns the group count.
+ */
+uint8_t multicast_groups_count(void);
+
+/**
+ * Returns the group address at the given index.
+ */
+const uint8_t *multicast_groups_address(uint8_t index);
+
+/**
+ * Returns the counters of a group, NULL if the group is not configured.
+ */
+const multicast_group_stats_t *multicast_groups_stats(const uint8_t address[16]);
+
+/**
+ * Traces the counters of every group.
+ */
+void multicast_groups_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MULTICAST_GROUPS_H */
@@ -2,45 +2,128 @@
  * Copyright (c) 2019, Pelion and affiliates.
  */
 
+#include "ns_types.h"
 #include "nsdynmemLIB.h"
+#include "platform/mbed_toolchain.h"
+#include "nanostack_heap_region.h"
 
-/* Enable nanostack extended heap only for specific targets and toolchains */
-#if (MBED_CONF_APP_NANOSTACK_EXTENDED_HEAP == true)
+#include "ns_trace.h"
+#define TRACE_GROUP "heap"
 
-#if defined(TARGET_K64F)
-#define NANOSTACK_EXTENDED_HEAP_REGION_SIZE (60*1024)
+#define NANOSTACK_HEAP_REGION_COUNT ((MBED_CONF_APP_NANOSTACK_HEAP_REGION_1_SIZE > 0) + \
+                                     (MBED_CONF_APP_NANOSTACK_HEAP_REGION_2_SIZE > 0) + \
+                                     (MBED_CONF_APP_NANOSTACK_HEAP_REGION_3_SIZE > 0))
+
+/*
+ * Regions without "nanostack-heap-region-N-section" go to .bss. A section
+ * must be placed by the linker script of the target, for example to CCM or
+ * DTCM RAM, and need not be zero-initialized.
+ */
+#if MBED_CONF_APP_NANOSTACK_HEAP_REGION_1_SIZE
+#ifdef MBED_CONF_APP_NANOSTACK_HEAP_REGION_1_SECTION
+MBED_SECTION(MBED_CONF_APP_NANOSTACK_HEAP_REGION_1_SECTION)
+#define HEAP_REGION_1_SECTION MBED_CONF_APP_NANOSTACK_HEAP_REGION_1_SECTION
+#else
+#define HEAP_REGION_1_SECTION ".bss"
+#endif
+MBED_ALIGN(8) static uint8_t heap_region_1[MBED_CONF_APP_NANOSTACK_HEAP_REGION_1_SIZE];
 #endif
 
-#if defined(TARGET_NUCLEO_F429ZI)
-#define NANOSTACK_EXTENDED_HEAP_REGION_SIZE (60*1024)
+#if MBED_CONF_APP_NANOSTACK_HEAP_REGION_2_SIZE
+#ifdef MBED_CONF_APP_NANOSTACK_HEAP_REGION_2_SECTION
+MBED_SECTION(MBED_CONF_APP_NANOSTACK_HEAP_REGION_2_SECTION)
+#define HEAP_REGION_2_SECTION MBED_CONF_APP_NANOSTACK_HEAP_REGION_2_SECTION
+#else
+#define HEAP_REGION_2_SECTION ".bss"
+#endif
+MBED_ALIGN(8) static uint8_t heap_region_2[MBED_CONF_APP_NANOSTACK_HEAP_REGION_2_SIZE];
 #endif
 
-#if defined(TARGET_DISCO_F769NI)
-#define NANOSTACK_EXTENDED_HEAP_REGION_SIZE (250*1024)
+#if MBED_CONF_APP_NANOSTACK_HEAP_REGION_3_SIZE
+#ifdef MBED_CONF_APP_NANOSTACK_HEAP_REGION_3_SECTION
+MBED_SECTION(MBED_CONF_APP_NANOSTACK_HEAP_REGION_3_SECTION)
+#define HEAP_REGION_3_SECTION MBED_CONF_APP_NANOSTACK_HEAP_REGION_3_SECTION
+#else
+#define HEAP_REGION_3_SECTION ".bss"
+#endif
+MBED_ALIGN(8) static uint8_t heap_region_3[MBED_CONF_APP_NANOSTACK_HEAP_REGION_3_SIZE];
 #endif
 
-#if defined(__IAR_SYSTEMS_ICC__) || defined(__IAR_SYSTEMS_ASM__) || defined(__ICCARM__)
-// currently - no IAR suport
-#undef NANOSTACK_EXTENDED_HEAP_REGION_SIZE
+#if NANOSTACK_HEAP_REGION_COUNT
+
+static const nanostack_heap_region_t heap_regions[NANOSTACK_HEAP_REGION_COUNT] = {
+#if MBED_CONF_APP_NANOSTACK_HEAP_REGION_1_SIZE
+    { heap_region_1, sizeof(heap_region_1), HEAP_REGION_1_SECTION },
+#endif
+#if MBED_CONF_APP_NANOSTACK_HEAP_REGION_2_SIZE
+    { heap_region_2, sizeof(heap_region_2), HEAP_REGION_2_SECTION },
+#endif
+#if MBED_CONF_APP_NANOSTACK_HEAP_REGION_3_SIZE
+    { heap_region_3, sizeof(heap_region_3), HEAP_REGION_3_SECTION },
 #endif
+};
 
-#endif // MBED_CONF_APP_NANOSTACK_EXTENDED_HEAP
+/* Regions the heap accepted */
+static bool heap_region_added[NANOSTACK_HEAP_REGION_COUNT];
 
+void nanostack_heap_region_add(void)
+{
+    for (uint8_t i = 0; i < NANOSTACK_HEAP_REGION_COUNT; i++) {
+        heap_region_added[i] = ns_dyn_mem_region_add(heap_regions[i].start, heap_regions[i].size) == 0;
+    }
+}
 
-#ifdef NANOSTACK_EXTENDED_HEAP_REGION_SIZE
+const nanostack_heap_region_t *nanostack_heap_region_get(uint8_t *count)
+{
+    *count = NANOSTACK_HEAP_REGION_COUNT;
+    return heap_regions;
+}
+
+void nanostack_heap_region_report(void)
+{
+    const mem_stat_t *heap_info = ns_dyn_mem_get_mem_stat();
+    uint32_t added = 0;
+
+    for (uint8_t i = 0; i < NANOSTACK_HEAP_REGION_COUNT; i++) {
+        if (heap_region_added[i]) {
+            added += heap_regions[i].size;
+            tr_info("Heap region %u: %lu bytes at %p in %s", i + 1, (unsigned long)heap_regions[i].size,
+                    heap_regions[i].start, heap_regions[i].section);
+        } else {
+            tr_error("Heap region %u: %lu bytes at %p in %s not added", i + 1,
+                     (unsigned long)heap_regions[i].size, heap_regions[i].start, heap_regions[i].section);
+        }
+    }
 
-// Heap region for GCC_ARM, ARMCC and ARMCLANG
-static uint8_t nanostack_extended_heap_region[NANOSTACK_EXTENDED_HEAP_REGION_SIZE];
+    if (heap_info) {
+        tr_info("Nanostack heap: %lu bytes, %lu in use, %lu of them in regions",
+                (unsigned long)heap_info->heap_sector_size,
+                (unsigned long)heap_info->heap_sector_allocated_bytes,
+                (unsigned long)added);
+    }
+}
+
+#else // NANOSTACK_HEAP_REGION_COUNT
 
 void nanostack_heap_region_add(void)
 {
-    ns_dyn_mem_region_add(nanostack_extended_heap_region, NANOSTACK_EXTENDED_HEAP_REGION_SIZE);
 }
 
-#else // NANOSTACK_EXTENDED_HEAP_REGION_SIZE
+const nanostack_heap_region_t *nanostack_heap_region_get(uint8_t *count)
+{
+    *count = 0;
+    return NULL;
+}
 
-void nanostack_heap_region_add(void)
+void nanostack_heap_region_report(void)
 {
+    const mem_stat_t *heap_info = ns_dyn_mem_get_mem_stat();
+
+    if (heap_info) {
+        tr_info("Nanostack heap: %lu bytes, %lu in use, no extra regions",
+                (unsigned long)heap_info->heap_sector_size,
+                (unsigned long)heap_info->heap_sector_allocated_bytes);
+    }
 }
 
-#endif // NANOSTACK_EXTENDED_HEAP_REGION_SIZE
+#endif // NANOSTACK_HEAP_REGION_COUNT
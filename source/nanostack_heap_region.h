@@ -5,13 +5,82 @@
 #ifndef NANOSTACK_HEAP_REGION_H
 #define NANOSTACK_HEAP_REGION_H
 
+#include "ns_types.h"
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+#define NANOSTACK_HEAP_REGION_MAX 3
+
+/*
+ * Region sizes come from "nanostack-heap-region-N-size". With
+ * "nanostack_extended_heap" set, the first region defaults to the size
+ * known for the target.
+ */
+#ifndef MBED_CONF_APP_NANOSTACK_HEAP_REGION_1_SIZE
+#if (MBED_CONF_APP_NANOSTACK_EXTENDED_HEAP == true)
+
+#if defined(TARGET_K64F)
+#define MBED_CONF_APP_NANOSTACK_HEAP_REGION_1_SIZE (60*1024)
+#endif
+
+#if defined(TARGET_NUCLEO_F429ZI)
+#define MBED_CONF_APP_NANOSTACK_HEAP_REGION_1_SIZE (60*1024)
+#endif
+
+#if defined(TARGET_DISCO_F769NI)
+#define MBED_CONF_APP_NANOSTACK_HEAP_REGION_1_SIZE (250*1024)
+#endif
+
+#endif // MBED_CONF_APP_NANOSTACK_EXTENDED_HEAP
+#endif
+
+#ifndef MBED_CONF_APP_NANOSTACK_HEAP_REGION_1_SIZE
+#define MBED_CONF_APP_NANOSTACK_HEAP_REGION_1_SIZE 0
+#endif
+
+#ifndef MBED_CONF_APP_NANOSTACK_HEAP_REGION_2_SIZE
+#define MBED_CONF_APP_NANOSTACK_HEAP_REGION_2_SIZE 0
+#endif
+
+#ifndef MBED_CONF_APP_NANOSTACK_HEAP_REGION_3_SIZE
+#define MBED_CONF_APP_NANOSTACK_HEAP_REGION_3_SIZE 0
+#endif
+
+/* Bytes in the regions added to the mesh API heap */
+#define NANOSTACK_HEAP_REGIONS_SIZE (MBED_CONF_APP_NANOSTACK_HEAP_REGION_1_SIZE + \
+                                     MBED_CONF_APP_NANOSTACK_HEAP_REGION_2_SIZE + \
+                                     MBED_CONF_APP_NANOSTACK_HEAP_REGION_3_SIZE)
+
+/* Nanostack heap known at compile time, the mesh API heap and the regions */
+#ifdef MBED_CONF_MBED_MESH_API_HEAP_SIZE
+#define NANOSTACK_HEAP_SIZE (MBED_CONF_MBED_MESH_API_HEAP_SIZE + NANOSTACK_HEAP_REGIONS_SIZE)
+#endif
+
+typedef struct nanostack_heap_region {
+    void *start;
+    uint32_t size;
+    const char *section;            /**< Linker section, ".bss" unless configured */
+} nanostack_heap_region_t;
+
+/**
+ * Adds the configured regions to the nanostack heap.
+ */
 void nanostack_heap_region_add(void);
 
+/**
+ * Returns the configured regions.
+ *
+ * \param count Set to the number of regions
+ */
+const nanostack_heap_region_t *nanostack_heap_region_get(uint8_t *count);
+
+/**
+ * Traces the regions and the use of the whole nanostack heap.
+ */
+void nanostack_heap_region_report(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,697 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#include <string.h>
+#include <ctype.h>
+#include "mbed.h"
+#include "platform/mbed_atomic.h"
+#include "hal/ticker_api.h"
+#include "hal/us_ticker_api.h"
+#include "ns_types.h"
+#include "common_functions.h"
+#include "eventOS_event.h"
+#include "eventOS_event_timer.h"
+#include "socket_api.h"
+#include "ip6string.h"
+#include "platform/arm_hal_phy.h"
+#include "platform/arm_hal_interrupt.h"
+#include "packet_capture.h"
+
+#include "ns_trace.h"
+#define TRACE_GROUP "pcap"
+
+#ifndef MBED_CONF_APP_CAPTURE_BUFFER_SIZE
+#define MBED_CONF_APP_CAPTURE_BUFFER_SIZE 0
+#endif
+
+#ifndef MBED_CONF_APP_CAPTURE_TRANSPORT
+#define MBED_CONF_APP_CAPTURE_TRANSPORT CAPTURE_UDP
+#endif
+
+#ifndef MBED_CONF_APP_CAPTURE_PORT
+#define MBED_CONF_APP_CAPTURE_PORT 5000
+#endif
+
+#ifndef MBED_CONF_APP_CAPTURE_DESTINATION
+#define MBED_CONF_APP_CAPTURE_DESTINATION ""
+#endif
+
+#ifndef MBED_CONF_APP_CAPTURE_UART_TX
+#define MBED_CONF_APP_CAPTURE_UART_TX NC
+#endif
+
+#ifndef MBED_CONF_APP_CAPTURE_UART_RX
+#define MBED_CONF_APP_CAPTURE_UART_RX NC
+#endif
+
+#ifndef MBED_CONF_APP_CAPTURE_UART_BAUD
+#define MBED_CONF_APP_CAPTURE_UART_BAUD 921600
+#endif
+
+#ifndef MBED_CONF_APP_CAPTURE_INTERFACES
+#define MBED_CONF_APP_CAPTURE_INTERFACES (CAPTURE_IF_MESH | CAPTURE_IF_BACKHAUL)
+#endif
+
+#ifndef MBED_CONF_APP_CAPTURE_SNAPLEN
+#define MBED_CONF_APP_CAPTURE_SNAPLEN 128
+#endif
+
+#ifndef MBED_CONF_APP_CAPTURE_PROTOCOL
+#define MBED_CONF_APP_CAPTURE_PROTOCOL -1
+#endif
+
+#ifndef MBED_CONF_APP_CAPTURE_MAC_FRAME_TYPES
+#define MBED_CONF_APP_CAPTURE_MAC_FRAME_TYPES 0xff
+#endif
+
+#ifndef MBED_CONF_APP_CAPTURE_ADDRESS
+#define MBED_CONF_APP_CAPTURE_ADDRESS ""
+#endif
+
+#ifndef MBED_CONF_APP_CAPTURE_FLUSH_MS
+#define MBED_CONF_APP_CAPTURE_FLUSH_MS 100
+#endif
+
+#if MBED_CONF_APP_CAPTURE_BUFFER_SIZE & (MBED_CONF_APP_CAPTURE_BUFFER_SIZE - 1)
+#error "capture-buffer-size must be a power of two"
+#endif
+
+/* pcapng block types, options and link types */
+#define PCAPNG_SHB                  0x0a0d0d0a
+#define PCAPNG_IDB                  0x00000001
+#define PCAPNG_EPB                  0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC     0x1a2b3c4d
+#define PCAPNG_SHB_LEN              28
+#define PCAPNG_OPT_IF_NAME          2
+#define PCAPNG_OPT_EPB_FLAGS        2
+#define PCAPNG_EPB_INBOUND          1
+#define PCAPNG_EPB_OUTBOUND         2
+#define LINKTYPE_ETHERNET           1
+#define LINKTYPE_IPV6               229
+#define LINKTYPE_IEEE802_15_4_NOFCS 230
+
+#define PCAPNG_PAD(len) (((len) + 3) & ~3)
+#define PCAPNG_IF_NAME_MAX 8
+/* Interface description block with the name option */
+#define PCAPNG_IDB_MAX_LEN (20 + 4 + PCAPNG_IF_NAME_MAX + 4)
+#define PCAPNG_SECTION_MAX_LEN (PCAPNG_SHB_LEN + PACKET_CAPTURE_TAP_MAX * PCAPNG_IDB_MAX_LEN)
+/* Enhanced packet block with the flags option */
+#define PCAPNG_EPB_LEN(len) (28 + PCAPNG_PAD(len) + 8 + 4 + 4)
+
+/* Fits the IPv6 minimum MTU */
+#define CAPTURE_DATAGRAM_MAX 1232
+#define CAPTURE_DATAGRAMS_PER_FLUSH 4
+#define CAPTURE_TIMER 1
+#define CAPTURE_STACK_SIZE 1024
+#define IPV6_HEADER_LEN 40
+#define IPV6_NH_UDP 17
+#define ETHERTYPE_IPV6 0x86dd
+
+typedef int8_t capture_tx_fn(uint8_t *data_ptr, uint16_t data_length, uint8_t tx_handle, data_protocol_e data_flow);
+
+typedef struct capture_tap {
+    arm_net_phy_rx_fn *rx_cb;
+    capture_tx_fn *tx;
+    char name[PCAPNG_IF_NAME_MAX + 1];
+    int8_t driver_id;
+    uint16_t linktype;
+    packet_capture_stats_t stats;
+} capture_tap_t;
+
+/* Ring entry header, the captured bytes follow */
+typedef struct capture_record {
+    uint64_t timestamp;
+    uint16_t orig_len;
+    uint16_t len;
+    uint8_t tap;
+    uint8_t direction;
+} capture_record_t;
+
+static capture_tap_t taps[PACKET_CAPTURE_TAP_MAX];
+static volatile uint8_t tap_count;
+static uint32_t records_sent;
+static uint32_t records_lost;
+static uint32_t used_max;
+
+#if MBED_CONF_APP_CAPTURE_BUFFER_SIZE
+
+MBED_STATIC_ASSERT(MBED_CONF_APP_CAPTURE_BUFFER_SIZE >= 4 * (sizeof(capture_record_t) + MBED_CONF_APP_CAPTURE_SNAPLEN),
+                   "capture-buffer-size is too small for capture-snaplen");
+MBED_STATIC_ASSERT(PCAPNG_SECTION_MAX_LEN + PCAPNG_EPB_LEN(MBED_CONF_APP_CAPTURE_SNAPLEN) <= CAPTURE_DATAGRAM_MAX,
+                   "capture-snaplen does not fit a UDP datagram");
+
+/*
+ * Ring of capture records. The taps write under the platform critical
+ * section, as receive callbacks run in driver context. The transport is the
+ * only reader and writes only the tail, so reading needs no lock.
+ */
+static uint8_t ring[MBED_CONF_APP_CAPTURE_BUFFER_SIZE];
+static volatile uint32_t ring_head;
+static volatile uint32_t ring_tail;
+static volatile bool section_due;
+
+static uint8_t filter_address[8];
+static uint8_t filter_address_len;
+static bool capture_started;
+
+static void ring_write(uint32_t pos, const void *data, uint32_t len)
+{
+    uint32_t offset = pos & (sizeof(ring) - 1);
+    uint32_t first = len < sizeof(ring) - offset ? len : sizeof(ring) - offset;
+
+    memcpy(&ring[offset], data, first);
+    memcpy(ring, (const uint8_t *)data + first, len - first);
+}
+
+static void ring_read(uint32_t pos, void *data, uint32_t len)
+{
+    uint32_t offset = pos & (sizeof(ring) - 1);
+    uint32_t first = len < sizeof(ring) - offset ? len : sizeof(ring) - offset;
+
+    memcpy(data, &ring[offset], first);
+    memcpy((uint8_t *)data + first, ring, len - first);
+}
+
+/* IEEE 802.15.4 addresses are sent least significant byte first */
+static bool address_match(const uint8_t *address, uint8_t len, bool reversed)
+{
+    if (len != filter_address_len) {
+        return false;
+    }
+    for (uint8_t i = 0; i < len; i++) {
+        if (address[reversed ? len - 1 - i : i] != filter_address[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool mac154_address_match(const uint8_t *frame, uint16_t len)
+{
+    static const uint8_t mode_len[4] = {0, 0, 2, 8};
+    uint16_t fcf = frame[0] | frame[1] << 8;
+    uint8_t dst_mode = (fcf >> 10) & 3;
+    uint8_t src_mode = (fcf >> 14) & 3;
+    uint8_t version = (fcf >> 12) & 3;
+    bool pan_id_compression = fcf & 0x0040;
+    bool dst_pan, src_pan;
+    const uint8_t *dst, *src;
+    uint16_t pos = 2;
+
+    /* Sequence number, suppressible in 2015 frames */
+    if (version < 2 || !(fcf & 0x0100)) {
+        pos++;
+    }
+
+    if (version < 2) {
+        dst_pan = dst_mode;
+        src_pan = src_mode && !pan_id_compression;
+    } else if (dst_mode && src_mode) {
+        /* IEEE 802.15.4-2015 table 7-2 */
+        dst_pan = dst_mode != 3 || src_mode != 3 || !pan_id_compression;
+        src_pan = (dst_mode != 3 || src_mode != 3) && !pan_id_compression;
+    } else {
+        dst_pan = dst_mode ? !pan_id_compression : !src_mode && pan_id_compression;
+        src_pan = src_mode && !pan_id_compression;
+    }
+
+    pos += dst_pan ? 2 : 0;
+    dst = &frame[pos];
+    pos += mode_len[dst_mode] + (src_pan ? 2 : 0);
+    src = &frame[pos];
+    pos += mode_len[src_mode];
+    if (pos > len) {
+        return false;
+    }
+
+    return address_match(dst, mode_len[dst_mode], true) || address_match(src, mode_len[src_mode], true);
+}
+
+static bool ipv6_filter(const uint8_t *ip, uint16_t len)
+{
+    if (len < IPV6_HEADER_LEN || (ip[0] >> 4) != 6) {
+        return MBED_CONF_APP_CAPTURE_PROTOCOL < 0;
+    }
+    if (MBED_CONF_APP_CAPTURE_PROTOCOL >= 0 && ip[6] != MBED_CONF_APP_CAPTURE_PROTOCOL) {
+        return false;
+    }
+#if MBED_CONF_APP_CAPTURE_TRANSPORT == CAPTURE_UDP
+    /* The capture datagrams themselves */
+    if (ip[6] == IPV6_NH_UDP && len >= IPV6_HEADER_LEN + 8 &&
+            common_read_16_bit(&ip[IPV6_HEADER_LEN + 2]) == MBED_CONF_APP_CAPTURE_PORT) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+/* Cheap checks on the link and IPv6 header only, the frame is not parsed further */
+static bool capture_filter(const capture_tap_t *tap, const uint8_t *frame, uint16_t len)
+{
+    switch (tap->linktype) {
+        case LINKTYPE_IEEE802_15_4_NOFCS:
+            if (len < 3 || !(MBED_CONF_APP_CAPTURE_MAC_FRAME_TYPES & (1 << (frame[0] & 7)))) {
+                return false;
+            }
+            /* Link layer security hides the payload, so the protocol filter does not apply */
+            return !filter_address_len || mac154_address_match(frame, len);
+
+        case LINKTYPE_ETHERNET:
+            if (len < 14) {
+                return false;
+            }
+            if (filter_address_len && !address_match(frame, 6, false) && !address_match(&frame[6], 6, false)) {
+                return false;
+            }
+            if (common_read_16_bit(&frame[12]) != ETHERTYPE_IPV6) {
+                return MBED_CONF_APP_CAPTURE_PROTOCOL < 0;
+            }
+            return ipv6_filter(&frame[14], len - 14);
+
+        default:
+            /* Raw IPv6 has no link addresses to match */
+            return ipv6_filter(frame, len);
+    }
+}
+
+static void capture_frame(uint8_t tap_index, uint8_t direction, const uint8_t *frame, uint16_t len)
+{
+    capture_tap_t *tap = &taps[tap_index];
+    capture_record_t record;
+    bool pass = capture_filter(tap, frame, len);
+
+    record.timestamp = ticker_read_us(get_us_ticker_data());
+    record.orig_len = len;
+    record.len = len < MBED_CONF_APP_CAPTURE_SNAPLEN ? len : MBED_CONF_APP_CAPTURE_SNAPLEN;
+    record.tap = tap_index;
+    record.direction = direction;
+
+    platform_enter_critical();
+    if (!pass) {
+        tap->stats.filtered++;
+    } else {
+        uint32_t head = ring_head;
+        uint32_t used = head - core_util_atomic_load_u32(&ring_tail);
+
+        if (sizeof(ring) - used < sizeof(record) + record.len) {
+            tap->stats.dropped++;
+        } else {
+            ring_write(head, &record, sizeof(record));
+            ring_write(head + sizeof(record), frame, record.len);
+            core_util_atomic_store_u32(&ring_head, head + sizeof(record) + record.len);
+            tap->stats.frames++;
+            used += sizeof(record) + record.len;
+            if (used > used_max) {
+                used_max = used;
+            }
+        }
+    }
+    platform_exit_critical();
+}
+
+/* phy_device_driver_s callbacks carry no context, so each tap gets its own set */
+template <int N>
+struct capture_trampoline {
+    static int8_t rx(const uint8_t *data_ptr, uint16_t data_len, uint8_t link_quality, int8_t dbm, int8_t driver_id)
+    {
+        capture_frame(N, PCAPNG_EPB_INBOUND, data_ptr, data_len);
+        return taps[N].rx_cb(data_ptr, data_len, link_quality, dbm, driver_id);
+    }
+    static int8_t tx(uint8_t *data_ptr, uint16_t data_length, uint8_t tx_handle, data_protocol_e data_flow)
+    {
+        int8_t ret = taps[N].tx(data_ptr, data_length, tx_handle, data_flow);
+        /* A busy driver is retried by the MAC, capture only the accepted attempt */
+        if (ret == 0) {
+            capture_frame(N, PCAPNG_EPB_OUTBOUND, data_ptr, data_length);
+        }
+        return ret;
+    }
+    static void bind(phy_device_driver_s *driver)
+    {
+        driver->phy_rx_cb = &rx;
+        driver->tx = &tx;
+    }
+};
+
+static void capture_bind(uint8_t tap_index, phy_device_driver_s *driver)
+{
+    switch (tap_index) {
+        case 0:
+            capture_trampoline<0>::bind(driver);
+            break;
+        case 1:
+            capture_trampoline<1>::bind(driver);
+            break;
+        case 2:
+            capture_trampoline<2>::bind(driver);
+            break;
+        case 3:
+            capture_trampoline<3>::bind(driver);
+            break;
+        default:
+            capture_trampoline<4>::bind(driver);
+            break;
+    }
+}
+
+static uint16_t capture_linktype(phy_link_type_e link_type)
+{
+    switch (link_type) {
+        case PHY_LINK_ETHERNET_TYPE:
+            return LINKTYPE_ETHERNET;
+        case PHY_LINK_15_4_2_4GHZ_TYPE:
+        case PHY_LINK_15_4_SUBGHZ_TYPE:
+            return LINKTYPE_IEEE802_15_4_NOFCS;
+        default:
+            return LINKTYPE_IPV6;
+    }
+}
+
+/* Section header and one interface description per tap, little-endian */
+static uint8_t *section_write(uint8_t *ptr, uint8_t count)
+{
+    ptr = common_write_32_bit_inverse(PCAPNG_SHB, ptr);
+    ptr = common_write_32_bit_inverse(PCAPNG_SHB_LEN, ptr);
+    ptr = common_write_32_bit_inverse(PCAPNG_BYTE_ORDER_MAGIC, ptr);
+    ptr = common_write_16_bit_inverse(1, ptr);
+    ptr = common_write_16_bit_inverse(0, ptr);
+    /* Section length not known */
+    memset(ptr, 0xff, 8);
+    ptr += 8;
+    ptr = common_write_32_bit_inverse(PCAPNG_SHB_LEN, ptr);
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint16_t name_len = strlen(taps[i].name);
+        uint32_t block_len = 20 + 4 + PCAPNG_PAD(name_len) + 4;
+
+        ptr = common_write_32_bit_inverse(PCAPNG_IDB, ptr);
+        ptr = common_write_32_bit_inverse(block_len, ptr);
+        ptr = common_write_16_bit_inverse(taps[i].linktype, ptr);
+        ptr = common_write_16_bit_inverse(0, ptr);
+        ptr = common_write_32_bit_inverse(MBED_CONF_APP_CAPTURE_SNAPLEN, ptr);
+        ptr = common_write_16_bit_inverse(PCAPNG_OPT_IF_NAME, ptr);
+        ptr = common_write_16_bit_inverse(name_len, ptr);
+        memset(ptr, 0, PCAPNG_PAD(name_len));
+        memcpy(ptr, taps[i].name, name_len);
+        ptr += PCAPNG_PAD(name_len);
+        ptr = common_write_32_bit_inverse(0, ptr);
+        ptr = common_write_32_bit_inverse(block_len, ptr);
+    }
+    return ptr;
+}
+
+/* Enhanced packet block of the record at the ring tail, timestamps in microseconds */
+static uint8_t *packet_write(uint8_t *ptr, uint32_t tail, const capture_record_t *record)
+{
+    uint32_t block_len = PCAPNG_EPB_LEN(record->len);
+
+    ptr = common_write_32_bit_inverse(PCAPNG_EPB, ptr);
+    ptr = common_write_32_bit_inverse(block_len, ptr);
+    ptr = common_write_32_bit_inverse(record->tap, ptr);
+    ptr = common_write_32_bit_inverse(record->timestamp >> 32, ptr);
+    ptr = common_write_32_bit_inverse(record->timestamp, ptr);
+    ptr = common_write_32_bit_inverse(record->len, ptr);
+    ptr = common_write_32_bit_inverse(record->orig_len, ptr);
+    memset(ptr, 0, PCAPNG_PAD(record->len));
+    ring_read(tail + sizeof(*record), ptr, record->len);
+    ptr += PCAPNG_PAD(record->len);
+    ptr = common_write_16_bit_inverse(PCAPNG_OPT_EPB_FLAGS, ptr);
+    ptr = common_write_16_bit_inverse(4, ptr);
+    ptr = common_write_32_bit_inverse(record->direction, ptr);
+    ptr = common_write_32_bit_inverse(0, ptr);
+    return common_write_32_bit_inverse(block_len, ptr);
+}
+
+#if MBED_CONF_APP_CAPTURE_TRANSPORT == CAPTURE_UDP
+
+static int8_t capture_tasklet_id = -1;
+static int8_t capture_socket = -1;
+static ns_address_t destination;
+static uint8_t datagram[CAPTURE_DATAGRAM_MAX];
+
+/*
+ * Every datagram is a complete pcapng section, so the collector can decode
+ * any datagram on its own and a plain concatenation is a valid file.
+ */
+static void capture_flush(void)
+{
+    for (uint8_t n = 0; n < CAPTURE_DATAGRAMS_PER_FLUSH; n++) {
+        uint32_t tail = ring_tail;
+        uint32_t head = core_util_atomic_load_u32(&ring_head);
+        uint32_t records = 0;
+        uint8_t count = core_util_atomic_load_u8(&tap_count);
+        uint8_t *ptr;
+
+        if (tail == head) {
+            return;
+        }
+
+        ptr = section_write(datagram, count);
+        while (tail != head) {
+            capture_record_t record;
+
+            ring_read(tail, &record, sizeof(record));
+            /* A tap added after the section header starts a new datagram */
+            if (record.tap >= count || (uint32_t)(ptr - datagram) + PCAPNG_EPB_LEN(record.len) > sizeof(datagram)) {
+                break;
+            }
+            ptr = packet_write(ptr, tail, &record);
+            tail += sizeof(record) + record.len;
+            records++;
+        }
+        core_util_atomic_store_u32(&ring_tail, tail);
+
+        /* Queued by the stack, a full queue loses these records and the next datagram follows */
+        if (socket_sendto(capture_socket, &destination, datagram, ptr - datagram) == 0) {
+            records_sent += records;
+        } else {
+            records_lost += records;
+        }
+    }
+}
+
+static void capture_socket_cb(void *cb)
+{
+    (void) cb;
+}
+
+static void capture_tasklet(arm_event_s *event)
+{
+    switch (event->event_type) {
+        case ARM_LIB_TASKLET_INIT_EVENT:
+            capture_tasklet_id = event->receiver;
+            eventOS_event_timer_request(CAPTURE_TIMER, ARM_LIB_SYSTEM_TIMER_EVENT,
+                                        capture_tasklet_id, MBED_CONF_APP_CAPTURE_FLUSH_MS);
+            break;
+
+        case ARM_LIB_SYSTEM_TIMER_EVENT:
+            if (event->event_id == CAPTURE_TIMER) {
+                /* Until the backhaul is up the buffer keeps the oldest frames */
+                if (capture_socket >= 0) {
+                    capture_flush();
+                }
+                eventOS_event_timer_request(CAPTURE_TIMER, ARM_LIB_SYSTEM_TIMER_EVENT,
+                                            capture_tasklet_id, MBED_CONF_APP_CAPTURE_FLUSH_MS);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+static bool capture_transport_start(void)
+{
+    memset(&destination, 0, sizeof(destination));
+    destination.type = ADDRESS_IPV6;
+    destination.identifier = MBED_CONF_APP_CAPTURE_PORT;
+    /* No default collector, frames must not go to a network nobody chose */
+    if (!strlen(MBED_CONF_APP_CAPTURE_DESTINATION)) {
+        tr_error("No capture destination, set \"capture-destination\"");
+        return false;
+    }
+    if (!stoip6(MBED_CONF_APP_CAPTURE_DESTINATION, strlen(MBED_CONF_APP_CAPTURE_DESTINATION), destination.address)) {
+        tr_error("Invalid capture destination %s", MBED_CONF_APP_CAPTURE_DESTINATION);
+        return false;
+    }
+
+    return eventOS_event_handler_create(&capture_tasklet, ARM_LIB_TASKLET_INIT_EVENT) >= 0;
+}
+
+void packet_capture_backhaul_ready(int8_t backhaul_if_id)
+{
+    if (capture_tasklet_id < 0) {
+        return;
+    }
+
+    if (capture_socket < 0) {
+        capture_socket = socket_open(SOCKET_UDP, 0, capture_socket_cb);
+        if (capture_socket < 0) {
+            tr_error("Capture socket open failed");
+            return;
+        }
+    }
+
+    socket_setsockopt(capture_socket, SOCKET_IPPROTO_IPV6, SOCKET_INTERFACE_SELECT,
+                      &backhaul_if_id, sizeof(backhaul_if_id));
+    tr_info("Capture to [%s]:%d", MBED_CONF_APP_CAPTURE_DESTINATION, MBED_CONF_APP_CAPTURE_PORT);
+}
+
+#else
+
+static Thread drain_thread(osPriorityLow, CAPTURE_STACK_SIZE, NULL, "capture");
+static UnbufferedSerial uart(MBED_CONF_APP_CAPTURE_UART_TX, MBED_CONF_APP_CAPTURE_UART_RX,
+                             MBED_CONF_APP_CAPTURE_UART_BAUD);
+static uint8_t block[PCAPNG_SECTION_MAX_LEN > PCAPNG_EPB_LEN(MBED_CONF_APP_CAPTURE_SNAPLEN) ?
+                     PCAPNG_SECTION_MAX_LEN : PCAPNG_EPB_LEN(MBED_CONF_APP_CAPTURE_SNAPLEN)];
+
+/* One pcapng stream, a new section whenever a tap is added */
+static void capture_drain(void)
+{
+    while (true) {
+        ThisThread::sleep_for(MBED_CONF_APP_CAPTURE_FLUSH_MS);
+
+        uint32_t tail = ring_tail;
+        while (tail != core_util_atomic_load_u32(&ring_head)) {
+            capture_record_t record;
+            uint8_t *end;
+
+            /* Checked per record, a tap added during the loop has frames after this one */
+            if (core_util_atomic_exchange_bool(&section_due, false)) {
+                uart.write(block, section_write(block, core_util_atomic_load_u8(&tap_count)) - block);
+            }
+            ring_read(tail, &record, sizeof(record));
+            end = packet_write(block, tail, &record);
+            tail += sizeof(record) + record.len;
+            /* Free the space before the slow part */
+            core_util_atomic_store_u32(&ring_tail, tail);
+
+            uart.write(block, end - block);
+            records_sent++;
+        }
+    }
+}
+
+static bool capture_transport_start(void)
+{
+    return drain_thread.start(callback(capture_drain)) == osOK;
+}
+
+void packet_capture_backhaul_ready(int8_t backhaul_if_id)
+{
+    (void) backhaul_if_id;
+}
+
+#endif // MBED_CONF_APP_CAPTURE_TRANSPORT
+
+/* Hex digits, separators ignored */
+static void filter_address_parse(const char *str)
+{
+    uint8_t digits = 0;
+
+    for (; *str && digits < 2 * sizeof(filter_address); str++) {
+        if (!isxdigit((unsigned char)*str)) {
+            continue;
+        }
+        uint8_t nibble = isdigit((unsigned char)*str) ? *str - '0' : (tolower((unsigned char)*str) - 'a' + 10);
+        filter_address[digits / 2] = filter_address[digits / 2] << 4 | nibble;
+        digits++;
+    }
+    filter_address_len = digits / 2;
+}
+
+void packet_capture_start(void)
+{
+    if (capture_started) {
+        return;
+    }
+
+    filter_address_parse(MBED_CONF_APP_CAPTURE_ADDRESS);
+    if (filter_address_len != 0 && filter_address_len != 2 && filter_address_len != 6 && filter_address_len != 8) {
+        tr_error("Invalid capture address %s", MBED_CONF_APP_CAPTURE_ADDRESS);
+        filter_address_len = 0;
+        return;
+    }
+
+    if (!capture_transport_start()) {
+        tr_error("Capture start failed");
+        return;
+    }
+    capture_started = true;
+}
+
+void packet_capture_tap(int8_t driver_id, const char *name, uint8_t flags)
+{
+    phy_device_driver_s *driver;
+    capture_tap_t *tap;
+
+    /* Without a transport the buffer would only fill up */
+    if (!capture_started || !(MBED_CONF_APP_CAPTURE_INTERFACES & flags) || tap_count >= PACKET_CAPTURE_TAP_MAX) {
+        return;
+    }
+    for (uint8_t i = 0; i < tap_count; i++) {
+        if (taps[i].driver_id == driver_id) {
+            return;
+        }
+    }
+
+    driver = arm_net_phy_driver_pointer(driver_id);
+    if (!driver || !driver->phy_rx_cb || !driver->tx) {
+        tr_error("Capture tap on driver %d failed", driver_id);
+        return;
+    }
+
+    tap = &taps[tap_count];
+    tap->rx_cb = driver->phy_rx_cb;
+    tap->tx = driver->tx;
+    tap->driver_id = driver_id;
+    tap->linktype = capture_linktype(driver->link_type);
+    strncpy(tap->name, name, PCAPNG_IF_NAME_MAX);
+    core_util_atomic_store_u8(&tap_count, tap_count + 1);
+    core_util_atomic_store_bool(&section_due, true);
+
+    platform_enter_critical();
+    capture_bind(tap - taps, driver);
+    platform_exit_critical();
+    tr_info("Capturing %s, link type %u", tap->name, tap->linktype);
+}
+
+#else
+
+void packet_capture_start(void)
+{
+}
+
+void packet_capture_tap(int8_t driver_id, const char *name, uint8_t flags)
+{
+    (void) driver_id;
+    (void) name;
+    (void) flags;
+}
+
+void packet_capture_backhaul_ready(int8_t backhaul_if_id)
+{
+    (void) backhaul_if_id;
+}
+
+#endif // MBED_CONF_APP_CAPTURE_BUFFER_SIZE
+
+const packet_capture_stats_t *packet_capture_stats_get(uint8_t tap)
+{
+    return tap < tap_count ? &taps[tap].stats : NULL;
+}
+
+void packet_capture_print(void)
+{
+    if (!tap_count) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < tap_count; i++) {
+        tr_info("Capture %s: %" PRIu32 " frames, %" PRIu32 " filtered, %" PRIu32 " dropped",
+                taps[i].name, taps[i].stats.frames, taps[i].stats.filtered, taps[i].stats.dropped);
+    }
+    tr_info("Capture sent %" PRIu32 " frames, %" PRIu32 " lost, buffer max %" PRIu32 "/%u bytes",
+            records_sent, records_lost, used_max, MBED_CONF_APP_CAPTURE_BUFFER_SIZE);
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#ifndef PACKET_CAPTURE_H
+#define PACKET_CAPTURE_H
+
+#include "ns_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Must be defined for the "capture-transport" preprocessor tests to work */
+#define CAPTURE_UDP     0
+#define CAPTURE_UART    1
+
+/* "capture-interfaces" flags */
+#define CAPTURE_IF_MESH     0x01
+#define CAPTURE_IF_BACKHAUL 0x02
+
+/* Mesh interfaces and the backhaul */
+#define PACKET_CAPTURE_TAP_MAX 5
+
+typedef struct packet_capture_stats {
+    uint32_t frames;                /**< Frames written to the buffer */
+    uint32_t filtered;              /**< Frames skipped by the filter */
+    uint32_t dropped;               /**< Frames dropped on a full buffer */
+} packet_capture_stats_t;
+
+/**
+ * Starts the capture transport. Does nothing unless "capture-buffer-size" is set.
+ * Call before the drivers are tapped, taps are refused until the transport runs.
+ */
+void packet_capture_start(void);
+
+/**
+ * Captures the frames of a PHY driver from now on. Call after the MAC has
+ * been created on the driver, the tap wraps the callbacks the MAC installed.
+ * Frames are copied to the capture buffer and passed on unchanged, a full
+ * buffer drops the copy and never the frame. Does nothing unless
+ * packet_capture_start() succeeded.
+ *
+ * Tap a driver after memory_pressure_join_gate(), the tap is then the
+ * outermost receive callback and captures the join requests the gate drops.
+ *
+ * \param driver_id PHY driver ID
+ * \param name Interface name for the capture, "mesh0" or "bh0"
+ * \param flags CAPTURE_IF_MESH or CAPTURE_IF_BACKHAUL, matched against "capture-interfaces"
+ */
+void packet_capture_tap(int8_t driver_id, const char *name, uint8_t flags);
+
+/**
+ * Sends the UDP capture records on the backhaul interface from now on.
+ */
+void packet_capture_backhaul_ready(int8_t backhaul_if_id);
+
+/**
+ * Returns the counters of a tap, NULL if there is no such tap.
+ */
+const packet_capture_stats_t *packet_capture_stats_get(uint8_t tap);
+
+/**
+ * Prints the tap and transport counters.
+ */
+void packet_capture_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PACKET_CAPTURE_H */
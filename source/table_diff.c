@@ -0,0 +1,390 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include "ns_types.h"
+#include "eventOS_event.h"
+#include "net_interface.h"
+#include "nsdynmemLIB.h"
+#include "borderrouter_helpers.h"
+#include "table_diff.h"
+
+#define LOWPAN_ND 0
+#define THREAD 1
+#define LOWPAN_WS 2
+
+#if MBED_CONF_APP_MESH_MODE == THREAD
+#include "thread_test_api.h"
+#elif MBED_CONF_APP_MESH_MODE == LOWPAN_WS
+#include "ws_bbr_api.h"
+#else
+#include "whiteboard_api.h"
+#endif
+
+#include "ns_trace.h"
+#define TRACE_GROUP "tdif"
+
+#ifndef MBED_CONF_APP_TABLE_DIFF_MAX_ENTRIES
+#define MBED_CONF_APP_TABLE_DIFF_MAX_ENTRIES 128
+#endif
+
+#ifndef MBED_CONF_APP_TABLE_DIFF_SLICE
+#define MBED_CONF_APP_TABLE_DIFF_SLICE 16
+#endif
+
+#define TABLE_ROUTE 0
+#define TABLE_NEIGHBOUR 1
+#define TABLE_CHILD 2
+#define TABLE_NODE 3
+
+/* Sent as APPLICATION_EVENT, event types of its own would clash with the ARM_LIB_* ones */
+#define TABLE_DIFF_EVENT 1
+
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+
+/* One entry, keyed by its address. Timers and link margins are not part of the hash. */
+typedef struct table_entry {
+    uint8_t key[16];
+    uint8_t key_len;
+    uint8_t table;
+    uint32_t hash;
+} table_entry_t;
+
+static const char *const table_names[] = {"Route", "Neighbour", "Child", "Node"};
+
+static table_entry_t snapshot[2][MBED_CONF_APP_TABLE_DIFF_MAX_ENTRIES];
+static uint16_t snapshot_count[2];
+static uint8_t current;
+static bool have_previous;
+
+static int8_t capture_interface_id = -1;
+static bool capture_running;
+static uint8_t capture_table;
+static uint8_t capture_index;
+static bool capture_truncated;
+
+static uint16_t old_pos;
+static uint16_t new_pos;
+static bool report_running;
+static table_diff_stats_t report;
+static table_diff_stats_t stats;
+static int8_t table_diff_tasklet_id = -1;
+
+static uint32_t fnv_hash(uint32_t hash, const void *data, uint16_t len)
+{
+    const uint8_t *ptr = data;
+
+    while (len--) {
+        hash = (hash ^ *ptr++) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/* Next free snapshot entry, NULL once the snapshot is full */
+static table_entry_t *capture_entry_add(uint8_t table, const uint8_t *key, uint8_t key_len)
+{
+    table_entry_t *entry;
+
+    if (snapshot_count[current] >= MBED_CONF_APP_TABLE_DIFF_MAX_ENTRIES) {
+        capture_truncated = true;
+        return NULL;
+    }
+    entry = &snapshot[current][snapshot_count[current]++];
+    memcpy(entry->key, key, 16);
+    entry->key_len = key_len;
+    entry->table = table;
+    entry->hash = FNV_OFFSET;
+    return entry;
+}
+
+#if MBED_CONF_APP_MESH_MODE == THREAD
+/* Link-local address of a neighbour from its extended address */
+static void link_local_address(uint8_t *address, const uint8_t *mac64)
+{
+    memset(address, 0, 16);
+    address[0] = 0xfe;
+    address[1] = 0x80;
+    memcpy(&address[8], mac64, 8);
+    address[8] ^= 2;
+}
+
+/* Reads one slice of the router neighbours, then of the children, by index */
+static bool capture_step(void)
+{
+    for (uint8_t n = 0; n < MBED_CONF_APP_TABLE_DIFF_SLICE; n++) {
+        table_entry_t *entry;
+        uint8_t address[16];
+        uint8_t mac64[8];
+        uint16_t short_addr;
+        uint8_t margin;
+        bool sleepy = false;
+
+        if (capture_table == TABLE_NEIGHBOUR) {
+            if (thread_test_neighbour_info_get(capture_interface_id, capture_index, &short_addr, mac64, &margin) != 0) {
+                capture_table = TABLE_CHILD;
+                capture_index = 0;
+                continue;
+            }
+        } else if (thread_test_child_info_get(capture_interface_id, capture_index, &short_addr, &sleepy,
+                                              mac64, &margin) != 0) {
+            return true;
+        }
+        capture_index++;
+
+        link_local_address(address, mac64);
+        entry = capture_entry_add(capture_table, address, 128);
+        if (!entry) {
+            return true;
+        }
+        entry->hash = fnv_hash(entry->hash, &short_addr, sizeof(short_addr));
+        entry->hash = fnv_hash(entry->hash, &sleepy, sizeof(sleepy));
+    }
+    return false;
+}
+#elif MBED_CONF_APP_MESH_MODE == LOWPAN_WS
+/* Copies the routes of the border router, at most one snapshot worth */
+static bool capture_step(void)
+{
+    bbr_route_info_t *table = ns_dyn_mem_temporary_alloc(sizeof(bbr_route_info_t) * MBED_CONF_APP_TABLE_DIFF_MAX_ENTRIES);
+    bbr_information_t info;
+    int count;
+
+    if (!table || ws_bbr_info_get(capture_interface_id, &info) != 0) {
+        ns_dyn_mem_free(table);
+        return true;
+    }
+
+    count = ws_bbr_routing_table_get(capture_interface_id, table, MBED_CONF_APP_TABLE_DIFF_MAX_ENTRIES);
+    capture_truncated = info.devices_in_network > MBED_CONF_APP_TABLE_DIFF_MAX_ENTRIES;
+    for (int i = 0; i < count; i++) {
+        table_entry_t *entry;
+        uint8_t address[16];
+
+        memcpy(address, info.dodag_id, 8);
+        memcpy(&address[8], table[i].target, 8);
+        entry = capture_entry_add(TABLE_ROUTE, address, 128);
+        if (!entry) {
+            break;
+        }
+        entry->hash = fnv_hash(entry->hash, table[i].parent, 8);
+    }
+    ns_dyn_mem_free(table);
+    return true;
+}
+#else
+/*
+ * Walks the registered nodes. Entries can be freed between events, so the
+ * walk is not split, but it stops when the snapshot is full.
+ */
+static bool capture_step(void)
+{
+    whiteboard_entry_t *node = NULL;
+
+    while ((node = whiteboard_get(node)) != NULL) {
+        table_entry_t *entry;
+
+        if (capture_interface_id >= 0 && node->interface_index != capture_interface_id) {
+            continue;
+        }
+        entry = capture_entry_add(TABLE_NODE, node->address, 128);
+        if (!entry) {
+            break;
+        }
+        entry->hash = fnv_hash(entry->hash, node->eui64, 8);
+        entry->hash = fnv_hash(entry->hash, &node->interface_index, sizeof(node->interface_index));
+    }
+    return true;
+}
+#endif
+
+static int entry_compare(const void *a, const void *b)
+{
+    const table_entry_t *entry_a = a;
+    const table_entry_t *entry_b = b;
+    int ret;
+
+    if (entry_a->table != entry_b->table) {
+        return entry_a->table - entry_b->table;
+    }
+    ret = memcmp(entry_a->key, entry_b->key, 16);
+    if (ret) {
+        return ret;
+    }
+    return entry_a->key_len - entry_b->key_len;
+}
+
+/* Sorts the new snapshot and folds entries with the same key, such as routes via several next hops */
+static void snapshot_sort(void)
+{
+    table_entry_t *entries = snapshot[current];
+    uint16_t count = 0;
+
+    qsort(entries, snapshot_count[current], sizeof(table_entry_t), entry_compare);
+
+    for (uint16_t i = 0; i < snapshot_count[current]; i++) {
+        if (count > 0 && entry_compare(&entries[count - 1], &entries[i]) == 0) {
+            entries[count - 1].hash += entries[i].hash;
+            continue;
+        }
+        entries[count++] = entries[i];
+    }
+    snapshot_count[current] = count;
+}
+
+static void entry_trace(const table_entry_t *entry, const char *change)
+{
+    tr_info_lazy("%s %s %s", table_names[entry->table], tr_ipv6_prefix(entry->key, entry->key_len), change);
+}
+
+static void diff_continue(void)
+{
+    arm_event_s event = {
+        .sender = table_diff_tasklet_id,
+        .receiver = table_diff_tasklet_id,
+        .priority = ARM_LIB_LOW_PRIORITY_EVENT,
+        .event_type = APPLICATION_EVENT,
+        .event_id = TABLE_DIFF_EVENT,
+    };
+
+    eventOS_event_send(&event);
+}
+
+static void diff_done(void)
+{
+    const table_entry_t *entries = snapshot[current];
+
+    for (uint16_t i = 0; i < snapshot_count[current]; i++) {
+        if (entries[i].table == TABLE_ROUTE || entries[i].table == TABLE_NODE) {
+            report.routes++;
+        } else {
+            report.neighbours++;
+        }
+    }
+    report.truncated = capture_truncated;
+    stats = report;
+    report_running = false;
+
+    if (!have_previous) {
+        have_previous = true;
+        tr_info("Tables: %u routes, %u neighbours", stats.routes, stats.neighbours);
+    } else if (stats.added || stats.removed || stats.changed) {
+        tr_info("Tables: %u routes, %u neighbours, %u added, %u removed, %u changed",
+                stats.routes, stats.neighbours, stats.added, stats.removed, stats.changed);
+    }
+    if (stats.truncated) {
+        tr_warn("Tables: more entries than tracked, increase table-diff-max-entries");
+    }
+}
+
+/* Compares at most one slice of the sorted snapshots */
+static void diff_step(void)
+{
+    const table_entry_t *old_entries = snapshot[current ^ 1];
+    const table_entry_t *new_entries = snapshot[current];
+    uint16_t old_count = have_previous ? snapshot_count[current ^ 1] : 0;
+    uint16_t new_count = have_previous ? snapshot_count[current] : 0;
+
+    for (uint8_t n = 0; n < MBED_CONF_APP_TABLE_DIFF_SLICE; n++) {
+        int cmp;
+
+        if (old_pos >= old_count && new_pos >= new_count) {
+            diff_done();
+            return;
+        }
+
+        if (old_pos >= old_count) {
+            cmp = 1;
+        } else if (new_pos >= new_count) {
+            cmp = -1;
+        } else {
+            cmp = entry_compare(&old_entries[old_pos], &new_entries[new_pos]);
+        }
+
+        if (cmp < 0) {
+            entry_trace(&old_entries[old_pos++], "removed");
+            report.removed++;
+        } else if (cmp > 0) {
+            entry_trace(&new_entries[new_pos++], "added");
+            report.added++;
+        } else {
+            if (old_entries[old_pos].hash != new_entries[new_pos].hash) {
+                entry_trace(&new_entries[new_pos], "changed");
+                report.changed++;
+            }
+            old_pos++;
+            new_pos++;
+        }
+    }
+    diff_continue();
+}
+
+/* Reads the tables slice by slice, then compares the sorted snapshots */
+static void report_step(void)
+{
+    if (!capture_running) {
+        diff_step();
+        return;
+    }
+    if (!capture_step()) {
+        diff_continue();
+        return;
+    }
+    capture_running = false;
+    snapshot_sort();
+    memset(&report, 0, sizeof(report));
+    old_pos = 0;
+    new_pos = 0;
+    diff_continue();
+}
+
+static void table_diff_tasklet(arm_event_s *event)
+{
+    switch (event->event_type) {
+        case ARM_LIB_TASKLET_INIT_EVENT:
+            table_diff_tasklet_id = event->receiver;
+            report_step();
+            break;
+
+        case APPLICATION_EVENT:
+            if (event->event_id == TABLE_DIFF_EVENT) {
+                report_step();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void table_diff_report_start(int8_t interface_id)
+{
+    if (report_running) {
+        return;
+    }
+    report_running = true;
+
+    /* The previous snapshot is kept in the other buffer */
+    if (have_previous) {
+        current ^= 1;
+    }
+    snapshot_count[current] = 0;
+    capture_interface_id = interface_id;
+    capture_table = TABLE_NEIGHBOUR;
+    capture_index = 0;
+    capture_truncated = false;
+    capture_running = true;
+
+    if (table_diff_tasklet_id < 0) {
+        eventOS_event_handler_create(&table_diff_tasklet, ARM_LIB_TASKLET_INIT_EVENT);
+    } else {
+        diff_continue();
+    }
+}
+
+const table_diff_stats_t *table_diff_stats_get(void)
+{
+    return &stats;
+}
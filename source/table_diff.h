@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#ifndef TABLE_DIFF_H
+#define TABLE_DIFF_H
+
+#include "ns_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct table_diff_stats {
+    uint16_t routes;                /**< Routes or registered nodes in the last snapshot */
+    uint16_t neighbours;            /**< Neighbours and children in the last snapshot */
+    uint16_t added;                 /**< Entries added since the previous snapshot */
+    uint16_t removed;               /**< Entries removed since the previous snapshot */
+    uint16_t changed;               /**< Entries changed since the previous snapshot */
+    bool truncated;                 /**< Tables had more entries than the snapshot holds */
+} table_diff_stats_t;
+
+/**
+ * Takes a snapshot of the mesh tables and traces the entries added, removed
+ * or changed since the previous one: registered nodes in 6LoWPAN ND, router
+ * neighbours and children in Thread, border router routes in Wi-SUN. The
+ * tables are read through the stack APIs, in slices where the stack allows
+ * it, and compared in slices on low priority events. Does nothing if the
+ * previous report is still running.
+ *
+ * \param interface_id Mesh interface, -1 for all in 6LoWPAN ND.
+ */
+void table_diff_report_start(int8_t interface_id);
+
+/**
+ * Returns the counts of the last complete report.
+ */
+const table_diff_stats_t *table_diff_stats_get(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TABLE_DIFF_H */
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include "mbed.h"
+#include "platform/mbed_atomic.h"
+#include "hal/ticker_api.h"
+#include "hal/us_ticker_api.h"
+#include "mbed_trace.h"
+#include "trace_sink.h"
+
+#ifndef MBED_CONF_APP_TRACE_SINK_SIZE
+#define MBED_CONF_APP_TRACE_SINK_SIZE 0
+#endif
+
+#ifndef MBED_CONF_APP_TRACE_SINK_BINARY
+#define MBED_CONF_APP_TRACE_SINK_BINARY false
+#endif
+
+#if MBED_CONF_APP_TRACE_SINK_SIZE & (MBED_CONF_APP_TRACE_SINK_SIZE - 1)
+#error "trace-sink-size must be a power of two"
+#endif
+
+/* Longer lines are cut, so that one line never takes more than a quarter of the buffer */
+#define TRACE_SINK_LINE_MAX 256
+#define TRACE_SINK_FLAG_DATA 0x01
+#define TRACE_SINK_STACK_SIZE 2048
+
+#if MBED_CONF_APP_TRACE_SINK_SIZE
+
+#if MBED_CONF_APP_TRACE_SINK_SIZE < 4 * (TRACE_SINK_FRAME_HEADER_LEN + TRACE_SINK_LINE_MAX)
+#error "trace-sink-size is too small"
+#endif
+
+/*
+ * Single producer, single consumer ring of binary mode frames. The mbed-trace
+ * mutex serializes the print calls, the drain thread is the only reader.
+ * Each side writes only its own index, so the ring itself needs no lock.
+ */
+static uint8_t ring[MBED_CONF_APP_TRACE_SINK_SIZE];
+static volatile uint32_t ring_head;
+static volatile uint32_t ring_tail;
+
+static uint16_t sequence;
+static uint32_t dropped_pending;
+static trace_sink_stats_t stats;
+static Thread drain_thread(osPriorityLow, TRACE_SINK_STACK_SIZE, NULL, "trace_sink");
+static Mutex trace_mutex;
+/* Console below stdio, binary frames must not get the "stdio-convert-newlines" CRLF */
+static FileHandle *console;
+
+static void trace_mutex_wait(void)
+{
+    trace_mutex.lock();
+}
+
+static void trace_mutex_release(void)
+{
+    trace_mutex.unlock();
+}
+
+static void ring_write(uint32_t pos, const void *data, uint32_t len)
+{
+    uint32_t offset = pos & (sizeof(ring) - 1);
+    uint32_t first = len < sizeof(ring) - offset ? len : sizeof(ring) - offset;
+
+    memcpy(&ring[offset], data, first);
+    memcpy(ring, (const uint8_t *)data + first, len - first);
+}
+
+static void ring_read(uint32_t pos, void *data, uint32_t len)
+{
+    uint32_t offset = pos & (sizeof(ring) - 1);
+    uint32_t first = len < sizeof(ring) - offset ? len : sizeof(ring) - offset;
+
+    memcpy(data, &ring[offset], first);
+    memcpy((uint8_t *)data + first, ring, len - first);
+}
+
+static bool frame_put(uint8_t type, uint16_t seq, const void *payload, uint16_t len)
+{
+    uint8_t header[TRACE_SINK_FRAME_HEADER_LEN];
+    uint32_t head = ring_head;
+    uint32_t used = head - core_util_atomic_load_u32(&ring_tail);
+    uint32_t timestamp = ticker_read_us(get_us_ticker_data()) / 1000;
+
+    if (sizeof(ring) - used < TRACE_SINK_FRAME_HEADER_LEN + len) {
+        return false;
+    }
+
+    header[0] = 0xa5;
+    header[1] = 0x5a;
+    header[2] = type;
+    header[3] = seq >> 8;
+    header[4] = seq;
+    header[5] = timestamp >> 24;
+    header[6] = timestamp >> 16;
+    header[7] = timestamp >> 8;
+    header[8] = timestamp;
+    header[9] = len >> 8;
+    header[10] = len;
+
+    ring_write(head, header, sizeof(header));
+    ring_write(head + sizeof(header), payload, len);
+    core_util_atomic_store_u32(&ring_head, head + sizeof(header) + len);
+
+    used += sizeof(header) + len;
+    if (used > stats.used_max) {
+        stats.used_max = used;
+    }
+    return true;
+}
+
+void trace_sink_print(const char *str)
+{
+    uint16_t len = strnlen(str, TRACE_SINK_LINE_MAX);
+    uint16_t seq = sequence++;
+
+    if (dropped_pending) {
+        uint8_t count[4] = {
+            (uint8_t)(dropped_pending >> 24), (uint8_t)(dropped_pending >> 16),
+            (uint8_t)(dropped_pending >> 8), (uint8_t)dropped_pending
+        };
+        if (frame_put(TRACE_SINK_FRAME_DROPPED, seq, count, sizeof(count))) {
+            dropped_pending = 0;
+        }
+    }
+
+    if (dropped_pending || !frame_put(TRACE_SINK_FRAME_LINE, seq, str, len)) {
+        if (!dropped_pending) {
+            stats.overflows++;
+        }
+        dropped_pending++;
+        stats.dropped++;
+        return;
+    }
+
+    stats.lines++;
+    drain_thread.flags_set(TRACE_SINK_FLAG_DATA);
+}
+
+static void console_write(const void *data, size_t len)
+{
+    const uint8_t *ptr = (const uint8_t *)data;
+
+    while (len) {
+        ssize_t written = console->write(ptr, len);
+        if (written <= 0) {
+            return;
+        }
+        ptr += written;
+        len -= written;
+    }
+}
+
+static void frame_output(const uint8_t *header, const char *payload, uint16_t len)
+{
+    if (MBED_CONF_APP_TRACE_SINK_BINARY) {
+        console_write(header, TRACE_SINK_FRAME_HEADER_LEN);
+        console_write(payload, len);
+    } else if (header[2] == TRACE_SINK_FRAME_DROPPED) {
+        const uint8_t *count = (const uint8_t *)payload;
+        printf("*** %lu trace lines dropped\n",
+               (unsigned long)count[0] << 24 | (unsigned long)count[1] << 16 | count[2] << 8 | count[3]);
+    } else {
+        printf("%.*s\n", len, payload);
+    }
+}
+
+static void trace_sink_drain(void)
+{
+    uint8_t header[TRACE_SINK_FRAME_HEADER_LEN];
+    char payload[TRACE_SINK_LINE_MAX];
+
+    while (true) {
+        ThisThread::flags_wait_any(TRACE_SINK_FLAG_DATA);
+
+        uint32_t tail = ring_tail;
+        if (MBED_CONF_APP_TRACE_SINK_BINARY) {
+            /* Text printed elsewhere goes out before the frames */
+            fflush(stdout);
+        }
+        while (tail != core_util_atomic_load_u32(&ring_head)) {
+            uint16_t len;
+
+            ring_read(tail, header, sizeof(header));
+            len = header[9] << 8 | header[10];
+            ring_read(tail + sizeof(header), payload, len);
+            tail += sizeof(header) + len;
+            /* Free the space before the slow part */
+            core_util_atomic_store_u32(&ring_tail, tail);
+
+            frame_output(header, payload, len);
+        }
+        fflush(stdout);
+    }
+}
+
+bool trace_sink_start(void)
+{
+    console = mbed_file_handle(STDOUT_FILENO);
+    if (!console) {
+        return false;
+    }
+    if (drain_thread.start(callback(trace_sink_drain)) != osOK) {
+        return false;
+    }
+    mbed_trace_mutex_wait_function_set(trace_mutex_wait);
+    mbed_trace_mutex_release_function_set(trace_mutex_release);
+    return true;
+}
+
+#else
+
+bool trace_sink_start(void)
+{
+    return false;
+}
+
+void trace_sink_print(const char *str)
+{
+    printf("%s\n", str);
+}
+
+static trace_sink_stats_t stats;
+
+#endif // MBED_CONF_APP_TRACE_SINK_SIZE
+
+const trace_sink_stats_t *trace_sink_stats_get(void)
+{
+    return &stats;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#ifndef TRACE_SINK_H
+#define TRACE_SINK_H
+
+#include "ns_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+ * Binary mode frame, big-endian:
+ *
+ *  0  sync 0xA5 0x5A       2
+ *  2  type                 1   TRACE_SINK_FRAME_*
+ *  3  sequence             2   counts every trace line, dropped ones included
+ *  5  timestamp, ms        4   when the line was traced
+ *  9  payload length       2
+ * 11  payload                  trace line without line end, or dropped line count (4)
+ */
+#define TRACE_SINK_FRAME_HEADER_LEN 11
+#define TRACE_SINK_FRAME_LINE       0
+#define TRACE_SINK_FRAME_DROPPED    1
+
+typedef struct trace_sink_stats {
+    uint32_t lines;                 /**< Lines written to the buffer */
+    uint32_t dropped;               /**< Lines dropped on a full buffer */
+    uint32_t overflows;             /**< Times the buffer ran full */
+    uint32_t used_max;              /**< Buffer high-water mark in bytes */
+} trace_sink_stats_t;
+
+/**
+ * Starts the thread that drains the trace buffer to the serial port.
+ * Does nothing unless "trace-sink-size" is set.
+ *
+ * \return true if trace_sink_print() can be used
+ */
+bool trace_sink_start(void);
+
+/**
+ * mbed-trace print function. Copies the line to the buffer and returns
+ * without waiting for the serial port. Lines that do not fit are dropped
+ * and replaced by a marker with the number of dropped lines.
+ */
+void trace_sink_print(const char *str);
+
+/**
+ * Returns the buffer counters.
+ */
+const trace_sink_stats_t *trace_sink_stats_get(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_SINK_H */
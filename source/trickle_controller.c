@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#define LOWPAN_ND 0
+#define THREAD 1
+#define LOWPAN_WS 2
+#if MBED_CONF_APP_MESH_MODE == LOWPAN_ND
+
+#include <string.h>
+#include "ns_types.h"
+#include "trickle_controller.h"
+
+#include "ns_trace.h"
+#define TRACE_GROUP "tric"
+
+#ifndef MBED_CONF_APP_RPL_TRICKLE_IMIN_MIN
+#define MBED_CONF_APP_RPL_TRICKLE_IMIN_MIN 10
+#endif
+
+#ifndef MBED_CONF_APP_RPL_TRICKLE_IMIN_MAX
+#define MBED_CONF_APP_RPL_TRICKLE_IMIN_MAX 15
+#endif
+
+#ifndef MBED_CONF_APP_RPL_TRICKLE_DOUBLINGS_MIN
+#define MBED_CONF_APP_RPL_TRICKLE_DOUBLINGS_MIN 4
+#endif
+
+#ifndef MBED_CONF_APP_RPL_TRICKLE_DOUBLINGS_MAX
+#define MBED_CONF_APP_RPL_TRICKLE_DOUBLINGS_MAX 9
+#endif
+
+#ifndef MBED_CONF_APP_RPL_TRICKLE_K_MIN
+#define MBED_CONF_APP_RPL_TRICKLE_K_MIN 3
+#endif
+
+#ifndef MBED_CONF_APP_RPL_TRICKLE_K_MAX
+#define MBED_CONF_APP_RPL_TRICKLE_K_MAX 10
+#endif
+
+#ifndef MBED_CONF_APP_RPL_TRICKLE_INCONSISTENCY_MAX
+#define MBED_CONF_APP_RPL_TRICKLE_INCONSISTENCY_MAX 5
+#endif
+
+#ifndef MBED_CONF_APP_RPL_TRICKLE_HOLD_WINDOWS
+#define MBED_CONF_APP_RPL_TRICKLE_HOLD_WINDOWS 3
+#endif
+
+#if MBED_CONF_APP_RPL_TRICKLE_IMIN_MIN > MBED_CONF_APP_RPL_TRICKLE_IMIN_MAX
+#error "rpl-trickle-imin-min is larger than rpl-trickle-imin-max"
+#endif
+
+#if MBED_CONF_APP_RPL_TRICKLE_DOUBLINGS_MIN > MBED_CONF_APP_RPL_TRICKLE_DOUBLINGS_MAX
+#error "rpl-trickle-doublings-min is larger than rpl-trickle-doublings-max"
+#endif
+
+/* RFC 6550 section 6.7.6: a redundancy constant of 0 turns suppression off */
+#if MBED_CONF_APP_RPL_TRICKLE_K_MIN < 1 || MBED_CONF_APP_RPL_TRICKLE_K_MIN > MBED_CONF_APP_RPL_TRICKLE_K_MAX || \
+    MBED_CONF_APP_RPL_TRICKLE_K_MAX > 0xff
+#error "rpl-trickle-k-min and rpl-trickle-k-max must be 1-255, min not larger than max"
+#endif
+
+/* Level 1 starts at 16 nodes, every further level at four times as many */
+#define LEVEL_NODES_BASE 16
+#define LEVEL_NODES_SHIFT 2
+
+static trickle_controller_stats_t ctrl;
+static uint32_t inconsistency_total;
+
+static uint32_t level_nodes(uint8_t level)
+{
+    return (uint32_t)LEVEL_NODES_BASE << (LEVEL_NODES_SHIFT * (level - 1));
+}
+
+/* Size level for a node count. Moving down needs 1/8 fewer nodes than moving up. */
+static uint8_t level_for_nodes(uint16_t nodes, uint8_t current)
+{
+    uint8_t level = 0;
+
+    while (level + 1 < TRICKLE_CONTROLLER_LEVELS && nodes >= level_nodes(level + 1)) {
+        level++;
+    }
+
+    if (current < TRICKLE_CONTROLLER_LEVELS && level < current &&
+            nodes >= level_nodes(current) - level_nodes(current) / 8) {
+        level = current;
+    }
+    return level;
+}
+
+/* Larger networks get a longer Imin, and fewer doublings keep Imax from growing as fast */
+static uint8_t level_imin(uint8_t level)
+{
+    return MBED_CONF_APP_RPL_TRICKLE_IMIN_MIN +
+           (MBED_CONF_APP_RPL_TRICKLE_IMIN_MAX - MBED_CONF_APP_RPL_TRICKLE_IMIN_MIN) * level /
+           (TRICKLE_CONTROLLER_LEVELS - 1);
+}
+
+static uint8_t level_doublings(uint8_t level)
+{
+    return MBED_CONF_APP_RPL_TRICKLE_DOUBLINGS_MAX -
+           (MBED_CONF_APP_RPL_TRICKLE_DOUBLINGS_MAX - MBED_CONF_APP_RPL_TRICKLE_DOUBLINGS_MIN) * level /
+           (TRICKLE_CONTROLLER_LEVELS - 1);
+}
+
+/* Denser networks hear more consistent DIOs, a smaller k suppresses more of them */
+static uint8_t level_k(uint8_t level)
+{
+    return MBED_CONF_APP_RPL_TRICKLE_K_MAX -
+           (MBED_CONF_APP_RPL_TRICKLE_K_MAX - MBED_CONF_APP_RPL_TRICKLE_K_MIN) * level /
+           (TRICKLE_CONTROLLER_LEVELS - 1);
+}
+
+/* Events after which RFC 6550 resets the Trickle timer: loops and unknown or broken RPL messages */
+static uint32_t stats_inconsistencies(const nwk_stats_t *stats)
+{
+    return (uint32_t)stats->ip_routeloop_detect + stats->rpl_unknown_instance + stats->rpl_malformed_message;
+}
+
+void trickle_controller_init(uint8_t imin, uint8_t doublings, uint8_t k, const nwk_stats_t *stats)
+{
+    memset(&ctrl, 0, sizeof(ctrl));
+    ctrl.level = TRICKLE_CONTROLLER_LEVELS;
+    ctrl.target_level = TRICKLE_CONTROLLER_LEVELS;
+    ctrl.imin = imin;
+    ctrl.doublings = doublings;
+    ctrl.k = k;
+    /* Events from before the start do not count against the first window */
+    inconsistency_total = stats_inconsistencies(stats);
+}
+
+bool trickle_controller_update(uint16_t nodes, const nwk_stats_t *stats, uint8_t *imin, uint8_t *doublings,
+                               uint8_t *k)
+{
+    uint32_t total = stats_inconsistencies(stats);
+    uint8_t target;
+
+    ctrl.nodes = nodes;
+    ctrl.inconsistencies = total - inconsistency_total;
+    inconsistency_total = total;
+
+    target = level_for_nodes(nodes, ctrl.level);
+    /* An unsettled network converges faster with shorter intervals */
+    if (ctrl.inconsistencies > MBED_CONF_APP_RPL_TRICKLE_INCONSISTENCY_MAX && target > 0) {
+        target--;
+    }
+
+    if (target != ctrl.target_level) {
+        ctrl.target_level = target;
+        ctrl.target_windows = 0;
+    }
+    if (ctrl.target_windows < MBED_CONF_APP_RPL_TRICKLE_HOLD_WINDOWS) {
+        ctrl.target_windows++;
+    }
+
+    if (target == ctrl.level || ctrl.target_windows < MBED_CONF_APP_RPL_TRICKLE_HOLD_WINDOWS) {
+        return false;
+    }
+
+    ctrl.level = target;
+    ctrl.imin = level_imin(target);
+    ctrl.doublings = level_doublings(target);
+    ctrl.k = level_k(target);
+    ctrl.changes++;
+    tr_info("Trickle level %u for %u nodes, %lu inconsistencies: Imin %u, doublings %u, k %u",
+            ctrl.level, ctrl.nodes, (unsigned long)ctrl.inconsistencies, ctrl.imin, ctrl.doublings, ctrl.k);
+
+    *imin = ctrl.imin;
+    *doublings = ctrl.doublings;
+    *k = ctrl.k;
+    return true;
+}
+
+const trickle_controller_stats_t *trickle_controller_stats_get(void)
+{
+    return &ctrl;
+}
+
+void trickle_controller_print(void)
+{
+    tr_info("Trickle level %u, Imin %u, doublings %u, k %u, nodes %u, inconsistencies %lu, changes %u",
+            ctrl.level, ctrl.imin, ctrl.doublings, ctrl.k, ctrl.nodes, (unsigned long)ctrl.inconsistencies,
+            ctrl.changes);
+}
+
+#endif // MBED_CONF_APP_MESH_MODE
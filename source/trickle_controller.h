@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2020, Pelion and affiliates.
+ */
+
+#ifndef TRICKLE_CONTROLLER_H
+#define TRICKLE_CONTROLLER_H
+
+#include "ns_types.h"
+#include "nwk_stats_api.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Number of network size levels the controller chooses between */
+#define TRICKLE_CONTROLLER_LEVELS 4
+
+typedef struct trickle_controller_stats {
+    uint16_t nodes;                 /**< Registered nodes seen in the last window */
+    uint32_t inconsistencies;       /**< Inconsistency events in the last window */
+    uint8_t level;                  /**< Level in use, TRICKLE_CONTROLLER_LEVELS until the first change */
+    uint8_t target_level;           /**< Level the last window asked for */
+    uint8_t target_windows;         /**< Consecutive windows that asked for target_level */
+    uint8_t imin;                   /**< DIOIntervalMin in use */
+    uint8_t doublings;              /**< DIOIntervalDoublings in use */
+    uint8_t k;                      /**< Redundancy constant in use */
+    uint16_t changes;               /**< Parameter changes since start */
+} trickle_controller_stats_t;
+
+/**
+ * Starts the controller from the configured Trickle parameters. Inconsistencies
+ * are counted from the current network statistics on.
+ */
+void trickle_controller_init(uint8_t imin, uint8_t doublings, uint8_t k, const nwk_stats_t *stats);
+
+/**
+ * Feeds one measurement window to the controller.
+ *
+ * \param nodes Nodes registered at the border router.
+ * \param stats Network statistics, inconsistencies are counted from the
+ *              change since the previous window.
+ * \param imin Set to the new DIOIntervalMin on a change.
+ * \param doublings Set to the new DIOIntervalDoublings on a change.
+ * \param k Set to the new redundancy constant on a change.
+ * \return true if the Trickle parameters should change
+ */
+bool trickle_controller_update(uint16_t nodes, const nwk_stats_t *stats, uint8_t *imin, uint8_t *doublings,
+                               uint8_t *k);
+
+/**
+ * Returns the controller state and the choice it made last.
+ */
+const trickle_controller_stats_t *trickle_controller_stats_get(void);
+
+/**
+ * Prints the controller state to the trace.
+ */
+void trickle_controller_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRICKLE_CONTROLLER_H */